@@ -0,0 +1,261 @@
+#ifndef ASYNC_BLOCK_READER_HPP
+#define ASYNC_BLOCK_READER_HPP
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<ioringapi.h>)
+#include <ioringapi.h>
+#define ASYNC_READER_HAS_IORING 1
+#endif
+
+#define DEFAULT_READ_QUEUE_DEPTH 8
+#define DEFAULT_READ_BLOCK_BYTES (4 * 1024 * 1024)
+#define DEFAULT_UNBUFFERED_BUFFERS 3
+// Unbuffered reads need sector-aligned offsets, sizes and buffers; a page
+// covers every sector size in use.
+#define UNBUFFERED_ALIGNMENT 4096
+
+// Receives each block as soon as its read completes, in completion order.
+// The readers cover totalBytes starting at firstByte in the file, and
+// offset is the block's position relative to firstByte. Returning false
+// stops the read. The thread-pool reader calls it from several threads at once.
+using BlockHandler = std::function<bool(const char* data, size_t bytes, uint64_t offset)>;
+
+// Positional reads on a synchronous handle from queueDepth threads, each
+// with its own buffer. Works on every Windows version.
+bool readBlocksThreadPool(const std::string& path, uint64_t firstByte, uint64_t totalBytes, size_t blockBytes, unsigned queueDepth, const BlockHandler& onBlock) {
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << path << ".\n";
+        return false;
+    }
+
+    std::atomic<uint64_t> nextBlock = 0;
+    std::atomic<bool> ok = true;
+    std::vector<std::thread> workers;
+    for (unsigned worker = 0; worker < std::max(1u, queueDepth); ++worker) {
+        workers.emplace_back([&] {
+            std::unique_ptr<char[]> buffer(new char[blockBytes]);
+            while (ok) {
+                const uint64_t offset = nextBlock++ * blockBytes;
+                if (offset >= totalBytes) return;
+
+                const DWORD bytes = static_cast<DWORD>(std::min<uint64_t>(blockBytes, totalBytes - offset));
+                OVERLAPPED position = {};
+                position.Offset = static_cast<DWORD>(firstByte + offset);
+                position.OffsetHigh = static_cast<DWORD>((firstByte + offset) >> 32);
+                DWORD read = 0;
+                if (!ReadFile(hFile, buffer.get(), bytes, &read, &position) || read != bytes || !onBlock(buffer.get(), bytes, offset)) {
+                    ok = false;
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    CloseHandle(hFile);
+    return ok;
+}
+
+// Reads with FILE_FLAG_NO_BUFFERING, so the data goes straight from the
+// device into page-aligned buffers and leaves nothing behind in the page
+// cache. With bufferCount buffers (2 = double, 3 = triple buffering) the
+// next reads are already in flight while onBlock processes the current
+// block. firstByte and blockBytes must be multiples of UNBUFFERED_ALIGNMENT.
+bool readBlocksUnbuffered(const std::string& path, uint64_t firstByte, uint64_t totalBytes, size_t blockBytes, unsigned bufferCount, const BlockHandler& onBlock) {
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING | FILE_FLAG_OVERLAPPED, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << path << " for unbuffered reading.\n";
+        return false;
+    }
+
+    struct Slot {
+        char* data;
+        OVERLAPPED overlapped;
+        uint64_t offset;
+        DWORD bytes;
+        bool pending;
+    };
+    std::vector<Slot> slots(std::max(2u, bufferCount));
+    bool ok = true;
+    for (auto& slot : slots) {
+        slot = {};
+        slot.data = static_cast<char*>(VirtualAlloc(NULL, blockBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+        slot.overlapped.hEvent = CreateEventA(NULL, TRUE, FALSE, NULL);
+        ok = ok && slot.data && slot.overlapped.hEvent;
+    }
+
+    uint64_t nextOffset = 0;
+    auto issue = [&](Slot& slot) {
+        slot.offset = nextOffset;
+        slot.bytes = static_cast<DWORD>(std::min<uint64_t>(blockBytes, totalBytes - nextOffset));
+        slot.overlapped.Offset = static_cast<DWORD>(firstByte + nextOffset);
+        slot.overlapped.OffsetHigh = static_cast<DWORD>((firstByte + nextOffset) >> 32);
+        nextOffset += slot.bytes;
+        // The tail is requested as a whole sector; the read stops at the end of the file.
+        const DWORD request = (slot.bytes + UNBUFFERED_ALIGNMENT - 1) & ~static_cast<DWORD>(UNBUFFERED_ALIGNMENT - 1);
+        slot.pending = ReadFile(hFile, slot.data, request, NULL, &slot.overlapped) || GetLastError() == ERROR_IO_PENDING;
+        return slot.pending;
+    };
+
+    for (auto& slot : slots) {
+        if (ok && nextOffset < totalBytes) ok = issue(slot);
+    }
+    // Buffers are issued round-robin, so they complete (and are drained
+    // after a failure) in that order too.
+    for (size_t i = 0; slots[i].pending; i = (i + 1) % slots.size()) {
+        Slot& slot = slots[i];
+        DWORD read = 0;
+        const bool completed = GetOverlappedResult(hFile, &slot.overlapped, &read, TRUE) && read >= slot.bytes;
+        slot.pending = false;
+        ok = ok && completed && onBlock(slot.data, slot.bytes, slot.offset);
+        if (ok && nextOffset < totalBytes) {
+            ok = issue(slot);
+        }
+    }
+
+    for (auto& slot : slots) {
+        if (slot.data) VirtualFree(slot.data, 0, MEM_RELEASE);
+        if (slot.overlapped.hEvent) CloseHandle(slot.overlapped.hEvent);
+    }
+    CloseHandle(hFile);
+    return ok;
+}
+
+#ifdef ASYNC_READER_HAS_IORING
+
+// The IoRing entry points only exist on Windows 11, so they are looked up at
+// run time instead of being imported; older systems use the thread pool.
+struct IoRingApi {
+    decltype(&CreateIoRing) create = nullptr;
+    decltype(&CloseIoRing) close = nullptr;
+    decltype(&SubmitIoRing) submit = nullptr;
+    decltype(&PopIoRingCompletion) popCompletion = nullptr;
+    decltype(&BuildIoRingRegisterFileHandles) registerFiles = nullptr;
+    decltype(&BuildIoRingRegisterBuffers) registerBuffers = nullptr;
+    decltype(&BuildIoRingReadFile) readFile = nullptr;
+
+    bool available() const { return create && close && submit && popCompletion && registerFiles && registerBuffers && readFile; }
+};
+
+const IoRingApi& ioRingApi() {
+    static const IoRingApi api = [] {
+        IoRingApi result;
+        HMODULE kernelBase = GetModuleHandleA("kernelbase.dll");
+        if (!kernelBase) return result;
+        result.create = reinterpret_cast<decltype(&CreateIoRing)>(GetProcAddress(kernelBase, "CreateIoRing"));
+        result.close = reinterpret_cast<decltype(&CloseIoRing)>(GetProcAddress(kernelBase, "CloseIoRing"));
+        result.submit = reinterpret_cast<decltype(&SubmitIoRing)>(GetProcAddress(kernelBase, "SubmitIoRing"));
+        result.popCompletion = reinterpret_cast<decltype(&PopIoRingCompletion)>(GetProcAddress(kernelBase, "PopIoRingCompletion"));
+        result.registerFiles = reinterpret_cast<decltype(&BuildIoRingRegisterFileHandles)>(GetProcAddress(kernelBase, "BuildIoRingRegisterFileHandles"));
+        result.registerBuffers = reinterpret_cast<decltype(&BuildIoRingRegisterBuffers)>(GetProcAddress(kernelBase, "BuildIoRingRegisterBuffers"));
+        result.readFile = reinterpret_cast<decltype(&BuildIoRingReadFile)>(GetProcAddress(kernelBase, "BuildIoRingReadFile"));
+        return result;
+    }();
+    return api;
+}
+
+#define IORING_REGISTRATION_TAG UINTPTR_MAX
+
+// Keeps queueDepth reads into registered buffers in flight. Each completed
+// buffer is handed to onBlock and immediately reused for the next block, so
+// the kernel keeps reading while the caller consumes. Sets unavailable and
+// returns false without reading anything when the system has no IoRing.
+bool readBlocksIoRing(const std::string& path, uint64_t firstByte, uint64_t totalBytes, size_t blockBytes, unsigned queueDepth, const BlockHandler& onBlock, bool& unavailable) {
+    const IoRingApi& api = ioRingApi();
+    queueDepth = std::max(1u, queueDepth);
+    HIORING ring = NULL;
+    IORING_CREATE_FLAGS flags = { IORING_CREATE_REQUIRED_FLAGS_NONE, IORING_CREATE_ADVISORY_FLAGS_NONE };
+    unavailable = !api.available() || FAILED(api.create(IORING_VERSION_1, flags, queueDepth + 2, queueDepth * 2 + 2, &ring));
+    if (unavailable) {
+        return false;
+    }
+
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_OVERLAPPED | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << path << ".\n";
+        api.close(ring);
+        return false;
+    }
+
+    std::vector<IORING_BUFFER_INFO> buffers(queueDepth);
+    for (auto& buffer : buffers) {
+        buffer.Address = VirtualAlloc(NULL, blockBytes, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        buffer.Length = static_cast<UINT32>(blockBytes);
+    }
+    std::vector<uint64_t> offsets(queueDepth);
+    std::vector<UINT32> lengths(queueDepth);
+
+    // Registration completes through the ring like any other operation.
+    bool ok = std::all_of(buffers.begin(), buffers.end(), [](const IORING_BUFFER_INFO& buffer) { return buffer.Address != nullptr; }) &&
+              SUCCEEDED(api.registerFiles(ring, 1, &hFile, IORING_REGISTRATION_TAG)) &&
+              SUCCEEDED(api.registerBuffers(ring, queueDepth, buffers.data(), IORING_REGISTRATION_TAG)) &&
+              SUCCEEDED(api.submit(ring, 2, INFINITE, NULL));
+    IORING_CQE completion;
+    while (ok && api.popCompletion(ring, &completion) == S_OK) {
+        ok = SUCCEEDED(completion.ResultCode);
+    }
+
+    uint64_t nextOffset = 0;
+    unsigned inFlight = 0;
+    auto queueRead = [&](UINT32 buffer) {
+        offsets[buffer] = nextOffset;
+        lengths[buffer] = static_cast<UINT32>(std::min<uint64_t>(blockBytes, totalBytes - nextOffset));
+        if (FAILED(api.readFile(ring, IoRingHandleRefFromIndex(0), IoRingBufferRefFromIndexAndOffset(buffer, 0),
+                                lengths[buffer], firstByte + nextOffset, buffer, IOSQE_FLAGS_NONE))) {
+            return false;
+        }
+        nextOffset += lengths[buffer];
+        ++inFlight;
+        return true;
+    };
+
+    for (UINT32 buffer = 0; ok && buffer < queueDepth && nextOffset < totalBytes; ++buffer) {
+        ok = queueRead(buffer);
+    }
+    // After a failure nothing new is queued, but reads already in flight
+    // still have to finish before their buffers can be freed.
+    while (inFlight > 0) {
+        if (FAILED(api.submit(ring, 1, INFINITE, NULL))) {
+            ok = false;
+            break;
+        }
+        while (api.popCompletion(ring, &completion) == S_OK) {
+            const UINT32 buffer = static_cast<UINT32>(completion.UserData);
+            --inFlight;
+            ok = ok && SUCCEEDED(completion.ResultCode) && completion.Information == lengths[buffer] &&
+                 onBlock(static_cast<const char*>(buffers[buffer].Address), lengths[buffer], offsets[buffer]);
+            if (ok && nextOffset < totalBytes) {
+                ok = queueRead(buffer);
+            }
+        }
+    }
+
+    api.close(ring);
+    CloseHandle(hFile);
+    for (auto& buffer : buffers) {
+        if (buffer.Address) VirtualFree(buffer.Address, 0, MEM_RELEASE);
+    }
+    return ok;
+}
+
+#else
+
+bool readBlocksIoRing(const std::string&, uint64_t, uint64_t, size_t, unsigned, const BlockHandler&, bool& unavailable) {
+    unavailable = true;
+    return false;
+}
+
+#endif // ASYNC_READER_HAS_IORING
+
+#endif // ASYNC_BLOCK_READER_HPP
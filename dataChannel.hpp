@@ -0,0 +1,380 @@
+#ifndef DATA_CHANNEL_HPP
+#define DATA_CHANNEL_HPP
+
+#include <windows.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "dataPipeProtocol.hpp"
+
+#define RING_MAGIC 0x474E4952 // "RING"
+#define DEFAULT_RING_SLOTS 8
+#define RING_ATTACH_TIMEOUT_MS 5000
+
+enum class PipelineTransport {
+    Pipe,
+    SharedRing,
+};
+
+const char* TransportName(PipelineTransport transport) {
+    return transport == PipelineTransport::SharedRing ? "ring" : "pipe";
+}
+
+// Returns false for names TransportName() never produces.
+bool ParseTransport(const std::string& name, PipelineTransport& transport) {
+    for (PipelineTransport candidate : { PipelineTransport::Pipe, PipelineTransport::SharedRing }) {
+        if (name == TransportName(candidate)) {
+            transport = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+// One-directional, single-producer/single-consumer stream of frames between
+// two pipeline stages. The producer fills a slot returned by acquireWrite()
+// and publishes it with commitWrite(); the consumer gets the next frame's
+// records in place from acquireRead() and hands the slot back with
+// releaseRead(). Each transport decides how much copying that involves.
+// acquireWrite() returns nullptr and acquireRead() false on failure.
+template <typename T>
+class DataChannel {
+public:
+    virtual ~DataChannel() = default;
+
+    virtual size_t slotCapacity() const = 0;
+    virtual T* acquireWrite() = 0;
+    virtual bool commitWrite(uint32_t recordCount, uint32_t flags = FRAME_FLAG_NONE) = 0;
+    virtual bool acquireRead(FrameHeader& header, const T*& records) = 0;
+    virtual void releaseRead() = 0;
+
+    // Producer side: blocks until the consumer has taken everything.
+    virtual bool close() = 0;
+
+    // Frames published but not yet consumed, as far as this end can tell.
+    virtual uint64_t queuedFrames() const = 0;
+
+    // Copies records that already live elsewhere into as many frames as needed.
+    virtual bool write(const T* records, size_t count);
+};
+
+template <typename T>
+bool DataChannel<T>::write(const T* records, size_t count) {
+    while (count > 0) {
+        size_t take = std::min(count, slotCapacity());
+        T* slot = acquireWrite();
+        if (!slot) return false;
+        std::memcpy(slot, records, take * sizeof(T));
+        if (!commitWrite(static_cast<uint32_t>(take))) return false;
+        records += take;
+        count -= take;
+    }
+    return true;
+}
+
+// Named pipe transport: frames are serialized through the kernel, so both
+// ends keep a private staging buffer.
+template <typename T>
+class PipeChannel : public DataChannel<T> {
+public:
+    PipeChannel(HANDLE hPipe, size_t capacity, bool producer);
+    ~PipeChannel() override;
+
+    size_t slotCapacity() const override { return capacity; }
+    T* acquireWrite() override { return buffer.data(); }
+    bool commitWrite(uint32_t recordCount, uint32_t flags) override;
+    bool acquireRead(FrameHeader& header, const T*& records) override;
+    void releaseRead() override {}
+    bool close() override;
+    uint64_t queuedFrames() const override;
+    bool write(const T* records, size_t count) override;
+
+private:
+    HANDLE hPipe;
+    size_t capacity;
+    bool producer;
+    std::vector<T> buffer;
+};
+
+template <typename T>
+PipeChannel<T>::PipeChannel(HANDLE hPipe, size_t capacity, bool producer)
+    : hPipe(hPipe), capacity(capacity), producer(producer) {
+    if (producer) {
+        buffer.resize(capacity);
+    }
+}
+
+template <typename T>
+PipeChannel<T>::~PipeChannel() {
+    CloseHandle(hPipe);
+}
+
+template <typename T>
+bool PipeChannel<T>::commitWrite(uint32_t recordCount, uint32_t flags) {
+    return WriteFrame(hPipe, buffer.data(), recordCount, flags);
+}
+
+template <typename T>
+bool PipeChannel<T>::acquireRead(FrameHeader& header, const T*& records) {
+    if (!ReadFrame(hPipe, header, buffer)) {
+        return false;
+    }
+    records = buffer.data();
+    return true;
+}
+
+template <typename T>
+bool PipeChannel<T>::close() {
+    return !producer || FlushFileBuffers(hPipe);
+}
+
+// Only the reading end can peek at the pipe; frames are counted at full size.
+template <typename T>
+uint64_t PipeChannel<T>::queuedFrames() const {
+    DWORD available = 0;
+    if (producer || !PeekNamedPipe(hPipe, NULL, 0, NULL, &available, NULL)) {
+        return 0;
+    }
+    const uint64_t frameBytes = sizeof(FrameHeader) + capacity * sizeof(T);
+    return (available + frameBytes - 1) / frameBytes;
+}
+
+// Records are already in a contiguous buffer, so write them straight to the
+// pipe instead of staging them.
+template <typename T>
+bool PipeChannel<T>::write(const T* records, size_t count) {
+    while (count > 0) {
+        size_t take = std::min(count, capacity);
+        if (!WriteFrame(hPipe, records, static_cast<uint32_t>(take))) return false;
+        records += take;
+        count -= take;
+    }
+    return true;
+}
+
+// Shared-memory transport: a named file mapping holds a control block and a
+// ring of fixed-size slots, each a FrameHeader followed by the payload. The
+// producer writes records directly into a slot and the consumer reads them
+// in place, so no byte crosses the kernel. head/tail are free-running slot
+// counters on separate cache lines; a side only signals the peer's event
+// when the peer announced that it is about to sleep.
+struct RingControl {
+    std::atomic<uint32_t> magic;
+    uint32_t slotCount;
+    uint64_t slotBytes;
+    alignas(64) std::atomic<uint64_t> head;
+    alignas(64) std::atomic<uint64_t> tail;
+    alignas(64) std::atomic<uint32_t> consumerWaiting;
+    alignas(64) std::atomic<uint32_t> producerWaiting;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring counters must be lock-free to live in shared memory");
+
+template <typename T>
+class SharedRingChannel : public DataChannel<T> {
+public:
+    SharedRingChannel() = default;
+    ~SharedRingChannel() override;
+
+    bool open(const std::string& name, size_t capacity, uint32_t slotCount);
+
+    size_t slotCapacity() const override { return capacity; }
+    T* acquireWrite() override;
+    bool commitWrite(uint32_t recordCount, uint32_t flags) override;
+    bool acquireRead(FrameHeader& header, const T*& records) override;
+    void releaseRead() override;
+    bool close() override;
+    uint64_t queuedFrames() const override { return control->head.load() - control->tail.load(); }
+
+private:
+    char* slot(uint64_t index) const {
+        return reinterpret_cast<char*>(control) + sizeof(RingControl) + (index % control->slotCount) * control->slotBytes;
+    }
+
+    void waitFor(std::atomic<uint32_t>& waitingFlag, HANDLE hEvent, const std::atomic<uint64_t>& counter, uint64_t value);
+
+    HANDLE hMapping = NULL;
+    HANDLE hDataEvent = NULL;
+    HANDLE hSpaceEvent = NULL;
+    RingControl* control = nullptr;
+    size_t capacity = 0;
+};
+
+template <typename T>
+SharedRingChannel<T>::~SharedRingChannel() {
+    if (control) UnmapViewOfFile(control);
+    if (hMapping) CloseHandle(hMapping);
+    if (hDataEvent) CloseHandle(hDataEvent);
+    if (hSpaceEvent) CloseHandle(hSpaceEvent);
+}
+
+template <typename T>
+bool SharedRingChannel<T>::open(const std::string& name, size_t capacity, uint32_t slotCount) {
+    this->capacity = capacity;
+    const uint64_t slotBytes = (sizeof(FrameHeader) + capacity * sizeof(T) + 63) & ~uint64_t(63);
+    const uint64_t mappingBytes = sizeof(RingControl) + slotBytes * slotCount;
+    const std::string base = "Local\\" + name + "Ring";
+
+    // Whichever stage starts first creates the mapping; the pagefile-backed
+    // section is zero-filled, which is already an empty ring.
+    hMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+        static_cast<DWORD>(mappingBytes >> 32), static_cast<DWORD>(mappingBytes), base.c_str());
+    if (!hMapping) {
+        std::cerr << "Failed to create ring mapping " << base << " (" << GetLastError() << ")." << std::endl;
+        return false;
+    }
+    const bool created = GetLastError() != ERROR_ALREADY_EXISTS;
+
+    control = static_cast<RingControl*>(MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(mappingBytes)));
+    hDataEvent = CreateEventA(NULL, FALSE, FALSE, (base + "Data").c_str());
+    hSpaceEvent = CreateEventA(NULL, FALSE, FALSE, (base + "Space").c_str());
+    if (!control || !hDataEvent || !hSpaceEvent) {
+        std::cerr << "Failed to map ring " << base << " (" << GetLastError() << ")." << std::endl;
+        return false;
+    }
+
+    if (created) {
+        control->slotCount = slotCount;
+        control->slotBytes = slotBytes;
+        control->magic.store(RING_MAGIC, std::memory_order_release);
+    } else {
+        ULONGLONG deadline = GetTickCount64() + RING_ATTACH_TIMEOUT_MS;
+        while (control->magic.load(std::memory_order_acquire) != RING_MAGIC) {
+            if (GetTickCount64() > deadline) {
+                std::cerr << "Timed out waiting for ring " << base << " to be initialized." << std::endl;
+                return false;
+            }
+            Sleep(1);
+        }
+        if (control->slotCount != slotCount || control->slotBytes != slotBytes) {
+            std::cerr << "Ring " << base << " was created with a different layout." << std::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template <typename T>
+void SharedRingChannel<T>::waitFor(std::atomic<uint32_t>& waitingFlag, HANDLE hEvent, const std::atomic<uint64_t>& counter, uint64_t value) {
+    // Announce, then re-check: the peer publishes before it tests the flag,
+    // so either it sees us waiting or we see its update.
+    while (counter.load() == value) {
+        waitingFlag.store(1);
+        if (counter.load() == value) {
+            WaitForSingleObject(hEvent, INFINITE);
+        }
+        waitingFlag.store(0);
+    }
+}
+
+template <typename T>
+T* SharedRingChannel<T>::acquireWrite() {
+    const uint64_t head = control->head.load(std::memory_order_relaxed);
+    waitFor(control->producerWaiting, hSpaceEvent, control->tail, head - control->slotCount);
+    return reinterpret_cast<T*>(slot(head) + sizeof(FrameHeader));
+}
+
+template <typename T>
+bool SharedRingChannel<T>::commitWrite(uint32_t recordCount, uint32_t flags) {
+    const uint64_t head = control->head.load(std::memory_order_relaxed);
+    FrameHeader* header = reinterpret_cast<FrameHeader*>(slot(head));
+    header->magic = FRAME_MAGIC;
+    header->elementType = static_cast<uint32_t>(ElementTypeOf<T>());
+    header->flags = flags;
+    header->recordCount = recordCount;
+
+    control->head.store(head + 1);
+    if (control->consumerWaiting.load()) {
+        SetEvent(hDataEvent);
+    }
+    return true;
+}
+
+template <typename T>
+bool SharedRingChannel<T>::acquireRead(FrameHeader& header, const T*& records) {
+    const uint64_t tail = control->tail.load(std::memory_order_relaxed);
+    waitFor(control->consumerWaiting, hDataEvent, control->head, tail);
+
+    header = *reinterpret_cast<const FrameHeader*>(slot(tail));
+    if (header.magic != FRAME_MAGIC || header.elementType != static_cast<uint32_t>(ElementTypeOf<T>())) {
+        std::cerr << "Corrupted frame in shared ring." << std::endl;
+        return false;
+    }
+    records = reinterpret_cast<const T*>(slot(tail) + sizeof(FrameHeader));
+    return true;
+}
+
+template <typename T>
+void SharedRingChannel<T>::releaseRead() {
+    control->tail.store(control->tail.load(std::memory_order_relaxed) + 1);
+    if (control->producerWaiting.load()) {
+        SetEvent(hSpaceEvent);
+    }
+}
+
+template <typename T>
+bool SharedRingChannel<T>::close() {
+    // The mapping disappears with its last handle, so the producer stays
+    // attached until the consumer has released every published slot.
+    const uint64_t head = control->head.load(std::memory_order_relaxed);
+    while (control->tail.load() != head) {
+        waitFor(control->producerWaiting, hSpaceEvent, control->tail, control->tail.load());
+    }
+    return true;
+}
+
+// With several sorter processes every partition gets its own pair of
+// channels ("DataPipe0", "SortedPipe0", ...); a single sorter keeps the
+// plain names.
+std::string PartitionChannelName(const std::string& base, uint32_t partition, uint32_t partitions) {
+    return partitions > 1 ? base + std::to_string(partition) : base;
+}
+
+// Channel endpoints are named without transport decoration ("DataPipe");
+// the factories map the name to a pipe path or a ring mapping.
+template <typename T>
+std::unique_ptr<DataChannel<T>> CreateProducerChannel(PipelineTransport transport, const std::string& name, size_t capacity) {
+    if (transport == PipelineTransport::SharedRing) {
+        auto ring = std::make_unique<SharedRingChannel<T>>();
+        if (!ring->open(name, capacity, DEFAULT_RING_SLOTS)) return nullptr;
+        return ring;
+    }
+
+    const std::string path = "\\\\.\\pipe\\" + name;
+    HANDLE hPipe = CreatePipeServer(path.c_str());
+    if (hPipe == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to create named pipe " << path << "." << std::endl;
+        return nullptr;
+    }
+    if (!AcceptPipeClient(hPipe)) {
+        std::cerr << "Failed to accept a client on " << path << "." << std::endl;
+        CloseHandle(hPipe);
+        return nullptr;
+    }
+    return std::make_unique<PipeChannel<T>>(hPipe, capacity, true);
+}
+
+template <typename T>
+std::unique_ptr<DataChannel<T>> OpenConsumerChannel(PipelineTransport transport, const std::string& name, size_t capacity) {
+    if (transport == PipelineTransport::SharedRing) {
+        auto ring = std::make_unique<SharedRingChannel<T>>();
+        if (!ring->open(name, capacity, DEFAULT_RING_SLOTS)) return nullptr;
+        return ring;
+    }
+
+    const std::string path = "\\\\.\\pipe\\" + name;
+    HANDLE hPipe = OpenPipeClient(path.c_str());
+    if (hPipe == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open named pipe " << path << "." << std::endl;
+        return nullptr;
+    }
+    return std::make_unique<PipeChannel<T>>(hPipe, capacity, false);
+}
+
+#endif // DATA_CHANNEL_HPP
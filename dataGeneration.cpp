@@ -2,57 +2,135 @@
 #include <iostream>
 #include <vector>
 #include <string>
+#include <algorithm>
+#include "dataChannel.hpp"
+#include "dataGenerator.hpp"
+#include "pipelineStage.hpp"
+#include "stageTelemetry.hpp"
 
-#define PIPE_NAME "\\\\.\\pipe\\DataPipe"
-#define BUFFER_SIZE 1024
+#define PREVIEW_RECORDS 100
 
-void GenerateData(std::vector<int>& data, size_t size) {
-    for (size_t i = 0; i < size; ++i) {
-        data.push_back(rand() % 100);
+int main(int argc, char** argv) {
+    StageArgs args(argc, argv);
+    const uint64_t recordCount = args.getSize("--records", 100);
+    const uint64_t chunkRecords = args.getSize("--chunk-records", DEFAULT_CHUNK_RECORDS);
+    const std::string transportName = args.getString("--transport", "pipe");
+    PipelineTransport transport;
+    if (!ParseTransport(transportName, transport)) {
+        std::cerr << "Unknown transport " << transportName << "; use pipe or ring." << std::endl;
+        return 1;
     }
-}
 
-int main() {
-    HANDLE hPipe = CreateNamedPipeA(
-        PIPE_NAME,
-        PIPE_ACCESS_OUTBOUND,
-        PIPE_TYPE_BYTE | PIPE_WAIT,
-        1,
-        BUFFER_SIZE,
-        BUFFER_SIZE,
-        0,
-        NULL
-    );
-
-    if (hPipe == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to create named pipe." << std::endl;
+    if (chunkRecords == 0 || chunkRecords > UINT32_MAX) {
+        std::cerr << "Invalid chunk size." << std::endl;
         return 1;
     }
 
-    std::vector<int> data;
-    GenerateData(data, 100);
-    std::cout << "Data: ";
-    for (int num : data) {
-        std::cout << num << " ";
+    const uint32_t partitions = static_cast<uint32_t>(std::max<uint64_t>(args.getSize("--partitions", 1), 1));
+    GeneratorConfig generatorConfig;
+    if (!ParseGeneratorConfig(args, recordCount, generatorConfig)) {
+        return 1;
     }
-    std::cout << std::endl;
+    const DataGenerator generator(generatorConfig, static_cast<unsigned>(args.getSize("--threads", 0)));
 
-    if (!ConnectNamedPipe(hPipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED) {
-        std::cerr << "Failed to connect to the sorting process." << std::endl;
-        CloseHandle(hPipe);
-        return 1;
+    std::vector<std::unique_ptr<DataChannel<int32_t>>> channels;
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        channels.push_back(CreateProducerChannel<int32_t>(transport, PartitionChannelName("DataPipe", partition, partitions), static_cast<size_t>(chunkRecords)));
+        if (!channels.back()) {
+            std::cerr << "Failed to connect to sorting process " << partition << "." << std::endl;
+            return 1;
+        }
     }
+    SignalReady(args);
+    StageTelemetry telemetry("generation", args);
+
+    std::cout << "Sending " << recordCount << " " << DistributionName(generator.getConfig().distribution)
+              << " records to " << partitions << " sorting process(es) over " << TransportName(transport) << "..." << std::endl;
+
+    const std::vector<int32_t> splitters = generator.sampleSplitters<int32_t>(partitions);
+    std::vector<int32_t*> slots(partitions, nullptr);
+    std::vector<uint32_t> slotFill(partitions, 0);
+    std::vector<int32_t> staging(partitions > 1 ? static_cast<size_t>(chunkRecords) : 0);
 
-    std::cout << "Sending data to the sorting process..." << std::endl;
+    // Publishes a partition's current slot and accounts for the time spent
+    // waiting on the channel.
+    auto commit = [&](uint32_t partition, uint32_t flags) {
+        const int64_t start = PipelineTimestamp();
+        if (!slots[partition] && !(slots[partition] = channels[partition]->acquireWrite())) return false;
+        const bool ok = channels[partition]->commitWrite(slotFill[partition], flags);
+        telemetry.addWriteBlocked(PipelineSeconds(start, PipelineTimestamp()));
+        telemetry.sampleQueueDepth(channels[partition]->queuedFrames());
+        slots[partition] = nullptr;
+        slotFill[partition] = 0;
+        return ok;
+    };
 
-    DWORD bytesWritten;
-    if (WriteFile(hPipe, data.data(), data.size() * sizeof(int), &bytesWritten, NULL)) {
+    // A single sorter gets records generated straight into the channel's
+    // slot, so the shared ring transport never copies them on this side.
+    // With several sorters a chunk is generated into a staging buffer and
+    // scattered into per-partition slots by key range.
+    for (uint64_t sent = 0; sent < recordCount;) {
+        const size_t count = static_cast<size_t>(std::min(chunkRecords, recordCount - sent));
+        int32_t* target = staging.data();
+        if (partitions == 1) {
+            const int64_t acquireStart = PipelineTimestamp();
+            target = slots[0] = channels[0]->acquireWrite();
+            telemetry.addWriteBlocked(PipelineSeconds(acquireStart, PipelineTimestamp()));
+            if (!target) {
+                std::cerr << "Failed to write data to the channel." << std::endl;
+                return 1;
+            }
+        }
+        const int64_t fillStart = PipelineTimestamp();
+        generator.fill(target, sent, count);
+
+        if (sent == 0) {
+            std::cout << "Data: ";
+            for (size_t i = 0; i < count && i < PREVIEW_RECORDS; ++i) {
+                std::cout << target[i] << " ";
+            }
+            std::cout << std::endl;
+        }
+
+        bool ok = true;
+        if (partitions == 1) {
+            telemetry.addChunkLatency(PipelineSeconds(fillStart, PipelineTimestamp()));
+            slotFill[0] = static_cast<uint32_t>(count);
+            ok = commit(0, FRAME_FLAG_NONE);
+        } else {
+            for (size_t i = 0; i < count && ok; ++i) {
+                const uint32_t partition = PartitionOf(splitters, target[i]);
+                if (!slots[partition] && !(slots[partition] = channels[partition]->acquireWrite())) {
+                    ok = false;
+                    break;
+                }
+                slots[partition][slotFill[partition]++] = target[i];
+                if (slotFill[partition] == chunkRecords) {
+                    ok = commit(partition, FRAME_FLAG_NONE);
+                }
+            }
+            telemetry.addChunkLatency(PipelineSeconds(fillStart, PipelineTimestamp()));
+        }
+        if (!ok) {
+            std::cerr << "Failed to write data to the channel." << std::endl;
+            return 1;
+        }
+        telemetry.addRecords(count, count * sizeof(int32_t));
+        sent += count;
+    }
+
+    // Partly filled slots go out together with the end-of-stream flag.
+    bool closed = true;
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        closed = commit(partition, FRAME_FLAG_END_OF_STREAM) && channels[partition]->close() && closed;
+    }
+    if (closed) {
         std::cout << "Data sent successfully." << std::endl;
     } else {
-        std::cerr << "Failed to write data to the pipe." << std::endl;
+        std::cerr << "Failed to write data to the channel." << std::endl;
     }
 
-    CloseHandle(hPipe);
+    telemetry.write();
     std::cout << "Data generation process completed." << std::endl;
-    return 0;
-}
\ No newline at end of file
+    return closed ? 0 : 1;
+}
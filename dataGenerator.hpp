@@ -0,0 +1,401 @@
+#ifndef DATA_GENERATOR_HPP
+#define DATA_GENERATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "pipelineStage.hpp"
+
+// Small enough that a DEFAULT_CHUNK_RECORDS chunk is still split four ways.
+#define GENERATOR_MIN_RECORDS_PER_THREAD (16 * 1024)
+#define SPLITTER_SAMPLES_PER_PARTITION 256
+
+enum class Distribution {
+    Uniform,
+    Zipf,
+    Sorted,
+    ReverseSorted,
+    NearlySorted,
+    FewUnique,
+};
+
+const char* DistributionName(Distribution distribution) {
+    switch (distribution) {
+    case Distribution::Uniform: return "uniform";
+    case Distribution::Zipf: return "zipf";
+    case Distribution::Sorted: return "sorted";
+    case Distribution::ReverseSorted: return "reverse";
+    case Distribution::NearlySorted: return "nearly-sorted";
+    case Distribution::FewUnique: return "few-unique";
+    }
+    return "uniform";
+}
+
+// Returns false for names DistributionName() never produces.
+bool ParseDistribution(const std::string& name, Distribution& distribution) {
+    for (Distribution candidate : { Distribution::Uniform, Distribution::Zipf, Distribution::Sorted,
+                                    Distribution::ReverseSorted, Distribution::NearlySorted, Distribution::FewUnique }) {
+        if (name == DistributionName(candidate)) {
+            distribution = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct GeneratorConfig {
+    Distribution distribution = Distribution::Uniform;
+    uint64_t seed = 1;
+    uint64_t totalRecords = 0;      // Sorted/reverse/nearly-sorted spread their values over this many records.
+    int64_t minValue = 0;
+    uint64_t valueRange = 100;      // Values fall into [minValue, minValue + valueRange).
+    double zipfExponent = 1.0;
+    uint32_t uniqueValues = 16;
+    double disorder = 0.01;         // Fraction of NearlySorted records replaced by random values.
+};
+
+// Shared by the stages and tools that generate data from the command line.
+// Reports an unknown --distribution and returns false.
+bool ParseGeneratorConfig(const StageArgs& args, uint64_t recordCount, GeneratorConfig& config) {
+    config = GeneratorConfig();
+    const std::string distributionName = args.getString("--distribution", DistributionName(config.distribution));
+    if (!ParseDistribution(distributionName, config.distribution)) {
+        std::cerr << "Unknown distribution " << distributionName
+                  << "; use uniform, zipf, sorted, reverse, nearly-sorted or few-unique." << std::endl;
+        return false;
+    }
+    config.seed = args.getSize("--seed", config.seed);
+    config.totalRecords = recordCount;
+    config.minValue = std::strtoll(args.getString("--min", "0").c_str(), nullptr, 10);
+    config.valueRange = args.getSize("--range", config.valueRange);
+    config.zipfExponent = std::strtod(args.getString("--zipf-exponent", "1.0").c_str(), nullptr);
+    config.uniqueValues = static_cast<uint32_t>(args.getSize("--unique", config.uniqueValues));
+    config.disorder = std::strtod(args.getString("--disorder", "0.01").c_str(), nullptr);
+    return true;
+}
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3").
+// A counter-based generator: the output for a counter depends on nothing
+// else, so record i always gets the same value no matter how the stream is
+// chunked or how many threads fill it.
+class Philox4x32 {
+public:
+    using Block = std::array<uint32_t, 4>;
+
+    explicit Philox4x32(uint64_t seed) : key{ static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) } {}
+
+    Block operator()(uint64_t counter, uint32_t stream = 0, uint32_t attempt = 0) const {
+        Block c = { static_cast<uint32_t>(counter), static_cast<uint32_t>(counter >> 32), attempt, stream };
+        uint32_t k0 = key[0];
+        uint32_t k1 = key[1];
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c[0];
+            const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c[2];
+            c = { static_cast<uint32_t>(p1 >> 32) ^ c[1] ^ k0, static_cast<uint32_t>(p1),
+                  static_cast<uint32_t>(p0 >> 32) ^ c[3] ^ k1, static_cast<uint32_t>(p0) };
+            k0 += 0x9E3779B9u;
+            k1 += 0xBB67AE85u;
+        }
+        return c;
+    }
+
+private:
+    std::array<uint32_t, 2> key;
+};
+
+// Threads kept alive for the lifetime of a DataGenerator, so filling a chunk
+// costs a wake-up instead of a thread creation per worker.
+class GeneratorWorkers {
+public:
+    explicit GeneratorWorkers(unsigned workerCount);
+    ~GeneratorWorkers();
+
+    // Runs task(part) for every part in [0, parts) and waits for all of them.
+    // The caller runs part 0 itself; parts must not exceed workerCount + 1.
+    void run(unsigned parts, const std::function<void(unsigned)>& task);
+
+private:
+    void workerLoop(unsigned part);
+
+    const std::function<void(unsigned)>* task = nullptr;
+    unsigned parts = 0;
+    unsigned remaining = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::vector<std::thread> workers;
+};
+
+GeneratorWorkers::GeneratorWorkers(unsigned workerCount) {
+    for (unsigned part = 1; part <= workerCount; ++part) {
+        workers.emplace_back(&GeneratorWorkers::workerLoop, this, part);
+    }
+}
+
+GeneratorWorkers::~GeneratorWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void GeneratorWorkers::workerLoop(unsigned part) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [this, seen] { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        if (part >= parts) continue;
+
+        const std::function<void(unsigned)>& current = *task;
+        lock.unlock();
+        current(part);
+        lock.lock();
+
+        if (--remaining == 0) {
+            workDone.notify_one();
+        }
+    }
+}
+
+void GeneratorWorkers::run(unsigned parts, const std::function<void(unsigned)>& task) {
+    if (parts <= 1) {
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        this->task = &task;
+        this->parts = parts;
+        remaining = parts - 1;
+        ++generation;
+    }
+    workAvailable.notify_all();
+
+    task(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return remaining == 0; });
+}
+
+// Fills record ranges according to a GeneratorConfig. Large ranges are split
+// across a pool of worker threads; every thread computes its records from
+// their indices. fill() is meant to be called from one thread at a time.
+class DataGenerator {
+public:
+    explicit DataGenerator(const GeneratorConfig& config, unsigned threadCount = 0);
+
+    template <typename T>
+    void fill(T* out, uint64_t firstIndex, size_t count) const;
+
+    // Key-range boundaries that cut the stream into roughly equal parts,
+    // estimated from a random sample of records; see PartitionOf().
+    template <typename T>
+    std::vector<T> sampleSplitters(uint32_t partitions, uint32_t samplesPerPartition = SPLITTER_SAMPLES_PER_PARTITION) const;
+
+    const GeneratorConfig& getConfig() const { return config; }
+
+private:
+    template <typename T>
+    void fillRange(T* out, uint64_t firstIndex, size_t count) const;
+
+    uint64_t uniform(uint64_t index, uint32_t stream) const;
+    double unitInterval(uint64_t index, uint32_t stream, uint32_t attempt) const;
+    uint64_t sortedOffset(uint64_t index) const;
+    uint64_t zipfRank(uint64_t index) const;
+
+    // Helpers of the rejection-inversion Zipf sampler (Hoermann & Derflinger).
+    double zipfH(double x) const { return std::exp(-config.zipfExponent * std::log(x)); }
+    double zipfHIntegral(double x) const;
+    double zipfHIntegralInverse(double x) const;
+
+    GeneratorConfig config;
+    unsigned threadCount;
+    std::unique_ptr<GeneratorWorkers> workers;
+    Philox4x32 philox;
+    double zipfHIntegralX1 = 0;
+    double zipfHIntegralN = 0;
+    double zipfS = 0;
+};
+
+DataGenerator::DataGenerator(const GeneratorConfig& config, unsigned threadCount)
+    : config(config), threadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())), philox(config.seed) {
+    if (this->threadCount > 1) {
+        workers = std::make_unique<GeneratorWorkers>(this->threadCount - 1);
+    }
+    this->config.valueRange = std::max<uint64_t>(this->config.valueRange, 1);
+    this->config.uniqueValues = std::max<uint32_t>(this->config.uniqueValues, 1);
+
+    const double n = static_cast<double>(this->config.valueRange);
+    zipfHIntegralX1 = zipfHIntegral(1.5) - 1.0;
+    zipfHIntegralN = zipfHIntegral(n + 0.5);
+    zipfS = 2.0 - zipfHIntegralInverse(zipfHIntegral(2.5) - zipfH(2.0));
+}
+
+double DataGenerator::zipfHIntegral(double x) const {
+    const double logX = std::log(x);
+    const double t = (1.0 - config.zipfExponent) * logX;
+    const double helper = std::abs(t) > 1e-8 ? std::expm1(t) / t : 1.0 + t * 0.5 * (1.0 + t / 3.0 * (1.0 + 0.25 * t));
+    return helper * logX;
+}
+
+double DataGenerator::zipfHIntegralInverse(double x) const {
+    double t = x * (1.0 - config.zipfExponent);
+    if (t < -1.0) t = -1.0;
+    const double helper = std::abs(t) > 1e-8 ? std::log1p(t) / t : 1.0 - t * (0.5 - t * (1.0 / 3.0 - 0.25 * t));
+    return std::exp(helper * x);
+}
+
+// Streams keep the random numbers used by different purposes independent.
+uint64_t DataGenerator::uniform(uint64_t index, uint32_t stream) const {
+    const Philox4x32::Block block = philox(index, stream);
+    if (config.valueRange <= (uint64_t(1) << 32)) {
+        return (static_cast<uint64_t>(block[0]) * config.valueRange) >> 32;
+    }
+    return ((static_cast<uint64_t>(block[0]) << 32) | block[1]) % config.valueRange;
+}
+
+double DataGenerator::unitInterval(uint64_t index, uint32_t stream, uint32_t attempt) const {
+    const Philox4x32::Block block = philox(index, stream, attempt);
+    return static_cast<double>(((static_cast<uint64_t>(block[0]) << 32) | block[1]) >> 11) * 0x1.0p-53;
+}
+
+uint64_t DataGenerator::sortedOffset(uint64_t index) const {
+    const uint64_t total = std::max<uint64_t>(config.totalRecords, 1);
+    return static_cast<uint64_t>(static_cast<double>(index) / static_cast<double>(total) * static_cast<double>(config.valueRange));
+}
+
+uint64_t DataGenerator::zipfRank(uint64_t index) const {
+    for (uint32_t attempt = 0;; ++attempt) {
+        const double u = zipfHIntegralN + unitInterval(index, 1, attempt) * (zipfHIntegralX1 - zipfHIntegralN);
+        const double x = zipfHIntegralInverse(u);
+        double k = std::floor(x + 0.5);
+        k = std::clamp(k, 1.0, static_cast<double>(config.valueRange));
+        if (k - x <= zipfS || u >= zipfHIntegral(k + 0.5) - zipfH(k)) {
+            return static_cast<uint64_t>(k) - 1;
+        }
+    }
+}
+
+template <typename T>
+void DataGenerator::fillRange(T* out, uint64_t firstIndex, size_t count) const {
+    const int64_t base = config.minValue;
+    const uint64_t last = std::max<uint64_t>(config.totalRecords, 1) - 1;
+
+    switch (config.distribution) {
+    case Distribution::Uniform: {
+        // One Philox block yields four 32-bit lanes; consume all of them.
+        const bool narrow = config.valueRange <= (uint64_t(1) << 32);
+        for (size_t i = 0; i < count;) {
+            const uint64_t index = firstIndex + i;
+            if (narrow && index % 4 == 0 && i + 4 <= count) {
+                const Philox4x32::Block block = philox(index / 4, 0);
+                for (int lane = 0; lane < 4; ++lane) {
+                    out[i + lane] = static_cast<T>(base + static_cast<int64_t>((static_cast<uint64_t>(block[lane]) * config.valueRange) >> 32));
+                }
+                i += 4;
+            } else if (narrow) {
+                const Philox4x32::Block block = philox(index / 4, 0);
+                out[i] = static_cast<T>(base + static_cast<int64_t>((static_cast<uint64_t>(block[index % 4]) * config.valueRange) >> 32));
+                ++i;
+            } else {
+                out[i] = static_cast<T>(base + static_cast<int64_t>(uniform(index, 0)));
+                ++i;
+            }
+        }
+        break;
+    }
+    case Distribution::Zipf:
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<T>(base + static_cast<int64_t>(zipfRank(firstIndex + i)));
+        }
+        break;
+    case Distribution::Sorted:
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = static_cast<T>(base + static_cast<int64_t>(sortedOffset(firstIndex + i)));
+        }
+        break;
+    case Distribution::ReverseSorted:
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t index = firstIndex + i;
+            out[i] = static_cast<T>(base + static_cast<int64_t>(sortedOffset(index <= last ? last - index : 0)));
+        }
+        break;
+    case Distribution::NearlySorted:
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t index = firstIndex + i;
+            const bool displaced = unitInterval(index, 2, 0) < config.disorder;
+            out[i] = static_cast<T>(base + static_cast<int64_t>(displaced ? uniform(index, 3) : sortedOffset(index)));
+        }
+        break;
+    case Distribution::FewUnique: {
+        const uint64_t step = std::max<uint64_t>(config.valueRange / config.uniqueValues, 1);
+        for (size_t i = 0; i < count; ++i) {
+            const Philox4x32::Block block = philox(firstIndex + i, 4);
+            out[i] = static_cast<T>(base + static_cast<int64_t>((block[0] % config.uniqueValues) * step));
+        }
+        break;
+    }
+    }
+}
+
+template <typename T>
+void DataGenerator::fill(T* out, uint64_t firstIndex, size_t count) const {
+    const unsigned parts = static_cast<unsigned>(std::clamp<size_t>(count / GENERATOR_MIN_RECORDS_PER_THREAD, 1, threadCount));
+    if (parts == 1) {
+        fillRange(out, firstIndex, count);
+        return;
+    }
+
+    workers->run(parts, [this, out, firstIndex, count, parts](unsigned part) {
+        const size_t begin = count * part / parts;
+        const size_t end = count * (part + 1) / parts;
+        fillRange(out + begin, firstIndex + begin, end - begin);
+    });
+}
+
+// Any record can be regenerated from its index alone, so sampling is just a
+// matter of picking random indices; no pass over the data is needed.
+template <typename T>
+std::vector<T> DataGenerator::sampleSplitters(uint32_t partitions, uint32_t samplesPerPartition) const {
+    if (partitions <= 1 || config.totalRecords == 0) return {};
+
+    std::vector<T> samples(static_cast<size_t>(partitions) * samplesPerPartition);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const Philox4x32::Block block = philox(i, 5);
+        const uint64_t index = ((static_cast<uint64_t>(block[0]) << 32) | block[1]) % config.totalRecords;
+        fillRange(&samples[i], index, 1);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    std::vector<T> splitters;
+    for (uint32_t partition = 1; partition < partitions; ++partition) {
+        splitters.push_back(samples[static_cast<size_t>(partition) * samplesPerPartition]);
+    }
+    return splitters;
+}
+
+// Partition p holds the keys in [splitters[p - 1], splitters[p]), so the
+// partitions concatenated in order are globally sorted.
+template <typename T>
+uint32_t PartitionOf(const std::vector<T>& splitters, T value) {
+    return static_cast<uint32_t>(std::upper_bound(splitters.begin(), splitters.end(), value) - splitters.begin());
+}
+
+#endif // DATA_GENERATOR_HPP
@@ -1,35 +1,180 @@
 #include <windows.h>
 #include <iostream>
+#include <chrono>
+#include <memory>
 #include <vector>
+#include "dataChannel.hpp"
+#include "externalSort.hpp"
+#include "outputWriter.hpp"
+#include "pipelineStage.hpp"
+#include "stageTelemetry.hpp"
 
-#define IN_PIPE_NAME "\\\\.\\pipe\\SortedPipe"
-
-int main() {
-    HANDLE hPipe = CreateFileA(
-        IN_PIPE_NAME,
-        GENERIC_READ,
-        0,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hPipe == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to open pipe." << std::endl;
+// The sorted stream of one partition, read a frame at a time.
+class PartitionReader {
+public:
+    PartitionReader(std::unique_ptr<DataChannel<int32_t>> channel, StageTelemetry& telemetry)
+        : channel(std::move(channel)), telemetry(telemetry) {}
+
+    // Moves to the next non-empty frame; false once the stream has ended.
+    bool next();
+
+    const int32_t* begin() const { return records; }
+    const int32_t* end() const { return records + count; }
+    bool failed() const { return error; }
+
+private:
+    std::unique_ptr<DataChannel<int32_t>> channel;
+    StageTelemetry& telemetry;
+    const int32_t* records = nullptr;
+    uint32_t count = 0;
+    bool holding = false;
+    bool endOfStream = false;
+    bool error = false;
+};
+
+bool PartitionReader::next() {
+    FrameHeader header;
+    do {
+        if (holding) {
+            channel->releaseRead();
+            holding = false;
+        }
+        if (endOfStream) {
+            count = 0;
+            return false;
+        }
+        telemetry.sampleQueueDepth(channel->queuedFrames());
+        const int64_t readStart = PipelineTimestamp();
+        if (!channel->acquireRead(header, records)) {
+            std::cerr << "Sorted stream ended without an end-of-stream frame." << std::endl;
+            error = true;
+            return false;
+        }
+        telemetry.addReadBlocked(PipelineSeconds(readStart, PipelineTimestamp()));
+        holding = true;
+        count = header.recordCount;
+        endOfStream = (header.flags & FRAME_FLAG_END_OF_STREAM) != 0;
+    } while (count == 0);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    StageArgs args(argc, argv);
+    const int64_t epoch = PipelineEpoch(args);
+    const OutputFormat format = args.has("--quiet") ? OutputFormat::None : ParseOutputFormat(args.getString("--format", "text"));
+    const std::string outputPath = args.getString("--output", "");
+    const uint64_t chunkRecords = args.getSize("--chunk-records", DEFAULT_CHUNK_RECORDS);
+    const std::string transportName = args.getString("--transport", "pipe");
+    PipelineTransport transport;
+    if (!ParseTransport(transportName, transport)) {
+        std::cerr << "Unknown transport " << transportName << "; use pipe or ring." << std::endl;
         return 1;
     }
-    std::cout << "Receiving data from the sorting process..." << std::endl;
+    const uint32_t partitions = static_cast<uint32_t>(std::max<uint64_t>(args.getSize("--partitions", 1), 1));
+    // Key-range partitions only need concatenating; --merge handles
+    // partitions whose key ranges overlap.
+    const bool merge = partitions > 1 && args.has("--merge");
 
-    std::vector<int> data(100);
-    DWORD bytesRead;
-    ReadFile(hPipe, data.data(), data.size() * sizeof(int), &bytesRead, NULL);
-    CloseHandle(hPipe);
+    std::vector<std::unique_ptr<DataChannel<int32_t>>> inputs;
+    for (uint32_t partition = 0; partition < partitions; ++partition) {
+        inputs.push_back(OpenConsumerChannel<int32_t>(transport, PartitionChannelName("SortedPipe", partition, partitions), static_cast<size_t>(chunkRecords)));
+        if (!inputs.back()) {
+            std::cerr << "Failed to open input channel " << partition << "." << std::endl;
+            return 1;
+        }
+    }
 
-    for (int num : data) {
-        std::cout << num << " ";
+    HANDLE hOutput = outputPath.empty()
+        ? GetStdHandle(STD_OUTPUT_HANDLE)
+        : CreateFileA(outputPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hOutput == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open output " << outputPath << "." << std::endl;
+        return 1;
+    }
+    SignalReady(args);
+    std::cout << "Receiving data from " << partitions << " sorting process(es)..." << std::endl;
+
+    OutputWriter writer(hOutput, format);
+    StageTelemetry telemetry("output", args);
+    std::vector<PartitionReader> readers;
+    for (auto& input : inputs) {
+        readers.emplace_back(std::move(input), telemetry);
     }
+
+    uint64_t recordsReceived = 0;
+    int64_t firstByte = 0;
+    auto emit = [&](const int32_t* records, size_t count) {
+        const int64_t start = PipelineTimestamp();
+        if (firstByte == 0) firstByte = start;
+        const bool ok = writer.write(records, count);
+        telemetry.addChunkLatency(PipelineSeconds(start, PipelineTimestamp()));
+        telemetry.addRecords(count, count * sizeof(int32_t));
+        recordsReceived += count;
+        return ok;
+    };
+
+    bool ok = true;
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!merge) {
+        for (auto& reader : readers) {
+            while (ok && reader.next()) {
+                ok = emit(reader.begin(), reader.end() - reader.begin());
+            }
+        }
+    } else {
+        LoserTree<int32_t> tree(readers.size());
+        for (size_t i = 0; i < readers.size(); ++i) {
+            tree.setHead(i, readers[i].next() ? readers[i].begin() : nullptr);
+        }
+        tree.build();
+
+        std::vector<int32_t> merged;
+        merged.reserve(static_cast<size_t>(chunkRecords));
+        while (ok && !tree.empty()) {
+            merged.push_back(tree.top());
+            PartitionReader& reader = readers[tree.winner()];
+            const int32_t* head = &tree.top() + 1;
+            if (head == reader.end()) {
+                head = reader.next() ? reader.begin() : nullptr;
+            }
+            tree.replaceWinner(head);
+            if (merged.size() == chunkRecords) {
+                ok = emit(merged.data(), merged.size());
+                merged.clear();
+            }
+        }
+        ok = ok && (merged.empty() || emit(merged.data(), merged.size()));
+    }
+    for (const auto& reader : readers) {
+        ok = ok && !reader.failed();
+    }
+    if (!ok) {
+        std::cerr << "Failed to write the sorted output." << std::endl;
+        return 1;
+    }
+    if (!writer.flush()) {
+        std::cerr << "Failed to write the sorted output." << std::endl;
+        return 1;
+    }
+    telemetry.addWriteBlocked(writer.writeSeconds());
+    auto end = std::chrono::high_resolution_clock::now();
+    const int64_t lastByte = PipelineTimestamp();
+    readers.clear();
+    if (!outputPath.empty()) {
+        CloseHandle(hOutput);
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double bytes = static_cast<double>(recordsReceived * sizeof(int32_t));
     std::cout << std::endl;
+    std::cout << "Received " << recordsReceived << " records in " << seconds << " seconds ("
+              << (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MiB/s), wrote "
+              << writer.bytesWritten() << " " << OutputFormatName(format) << " bytes." << std::endl;
+    if (firstByte != 0) {
+        std::cout << "Time to first byte: " << PipelineSeconds(epoch, firstByte) << " s, end-to-end latency: "
+                  << PipelineSeconds(epoch, lastByte) << " s." << std::endl;
+    }
+    telemetry.write();
     std::cout << "Data output process completed." << std::endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,195 @@
+#ifndef DATA_PIPE_PROTOCOL_HPP
+#define DATA_PIPE_PROTOCOL_HPP
+
+#include <windows.h>
+#include <cstdint>
+#include <iostream>
+#include <type_traits>
+#include <vector>
+#include "keyedRecord.hpp"
+
+#define PIPE_BUFFER_SIZE (1024 * 1024)
+#define FRAME_MAGIC 0x4D524654 // "TFRM"
+#define DEFAULT_CHUNK_RECORDS (64 * 1024)
+#define PIPE_CONNECT_TIMEOUT_MS 10000
+
+// Every message on DataPipe/SortedPipe is a FrameHeader followed by
+// recordCount elements of elementType. A stream is any number of data
+// frames terminated by a frame carrying FRAME_FLAG_END_OF_STREAM.
+enum class ElementType : uint32_t {
+    Int32 = 1,
+    Int64 = 2,
+    Float32 = 3,
+    Float64 = 4,
+    Record16 = 5,
+    Record64 = 6,
+    Record128 = 7,
+};
+
+enum FrameFlags : uint32_t {
+    FRAME_FLAG_NONE = 0,
+    FRAME_FLAG_END_OF_STREAM = 1,
+};
+
+struct FrameHeader {
+    uint32_t magic;
+    uint32_t elementType;
+    uint32_t flags;
+    uint32_t recordCount;
+};
+
+static_assert(sizeof(FrameHeader) == 16, "FrameHeader is part of the wire format");
+
+template <typename T>
+constexpr ElementType ElementTypeOf() {
+    static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> || std::is_same_v<T, float> || std::is_same_v<T, double> ||
+                  std::is_same_v<T, Record16> || std::is_same_v<T, Record64> || std::is_same_v<T, Record128>,
+                  "Unsupported frame element type");
+    if constexpr (std::is_same_v<T, int32_t>) return ElementType::Int32;
+    else if constexpr (std::is_same_v<T, int64_t>) return ElementType::Int64;
+    else if constexpr (std::is_same_v<T, float>) return ElementType::Float32;
+    else if constexpr (std::is_same_v<T, double>) return ElementType::Float64;
+    else if constexpr (std::is_same_v<T, Record16>) return ElementType::Record16;
+    else if constexpr (std::is_same_v<T, Record64>) return ElementType::Record64;
+    else return ElementType::Record128;
+}
+
+// Calls visit with std::type_identity<T> for the C++ type of an element
+// type, so code written once as a template can serve a type read at run
+// time. Returns false for unknown types.
+template <typename Visit>
+bool VisitElementType(ElementType type, Visit&& visit) {
+    switch (type) {
+    case ElementType::Int32: return visit(std::type_identity<int32_t>());
+    case ElementType::Int64: return visit(std::type_identity<int64_t>());
+    case ElementType::Float32: return visit(std::type_identity<float>());
+    case ElementType::Float64: return visit(std::type_identity<double>());
+    case ElementType::Record16: return visit(std::type_identity<Record16>());
+    case ElementType::Record64: return visit(std::type_identity<Record64>());
+    case ElementType::Record128: return visit(std::type_identity<Record128>());
+    }
+    return false;
+}
+
+size_t ElementSize(ElementType type) {
+    switch (type) {
+    case ElementType::Int32: return sizeof(int32_t);
+    case ElementType::Int64: return sizeof(int64_t);
+    case ElementType::Float32: return sizeof(float);
+    case ElementType::Float64: return sizeof(double);
+    case ElementType::Record16: return sizeof(Record16);
+    case ElementType::Record64: return sizeof(Record64);
+    case ElementType::Record128: return sizeof(Record128);
+    }
+    return 0;
+}
+
+// WriteFile/ReadFile take a DWORD length and pipes may return short reads,
+// so every transfer goes through these loops.
+bool WriteExact(HANDLE hPipe, const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        DWORD toWrite = static_cast<DWORD>(size < PIPE_BUFFER_SIZE ? size : PIPE_BUFFER_SIZE);
+        DWORD bytesWritten = 0;
+        if (!WriteFile(hPipe, cursor, toWrite, &bytesWritten, NULL) || bytesWritten == 0) {
+            return false;
+        }
+        cursor += bytesWritten;
+        size -= bytesWritten;
+    }
+    return true;
+}
+
+bool ReadExact(HANDLE hPipe, void* data, size_t size) {
+    char* cursor = static_cast<char*>(data);
+    while (size > 0) {
+        DWORD toRead = static_cast<DWORD>(size < PIPE_BUFFER_SIZE ? size : PIPE_BUFFER_SIZE);
+        DWORD bytesRead = 0;
+        if (!ReadFile(hPipe, cursor, toRead, &bytesRead, NULL) || bytesRead == 0) {
+            return false;
+        }
+        cursor += bytesRead;
+        size -= bytesRead;
+    }
+    return true;
+}
+
+template <typename T>
+bool WriteFrame(HANDLE hPipe, const T* records, uint32_t recordCount, uint32_t flags = FRAME_FLAG_NONE) {
+    FrameHeader header = { FRAME_MAGIC, static_cast<uint32_t>(ElementTypeOf<T>()), flags, recordCount };
+    if (!WriteExact(hPipe, &header, sizeof(header))) {
+        return false;
+    }
+    return WriteExact(hPipe, records, static_cast<size_t>(recordCount) * sizeof(T));
+}
+
+template <typename T>
+bool WriteEndOfStream(HANDLE hPipe) {
+    return WriteFrame<T>(hPipe, nullptr, 0, FRAME_FLAG_END_OF_STREAM);
+}
+
+// Reads one frame into records (resized to the frame's record count).
+// Returns false on a broken pipe or a malformed header.
+template <typename T>
+bool ReadFrame(HANDLE hPipe, FrameHeader& header, std::vector<T>& records) {
+    if (!ReadExact(hPipe, &header, sizeof(header))) {
+        return false;
+    }
+    if (header.magic != FRAME_MAGIC) {
+        std::cerr << "Invalid frame magic " << std::hex << header.magic << std::dec << "." << std::endl;
+        return false;
+    }
+    if (header.elementType != static_cast<uint32_t>(ElementTypeOf<T>())) {
+        std::cerr << "Unexpected frame element type " << header.elementType << "." << std::endl;
+        return false;
+    }
+    records.resize(header.recordCount);
+    return ReadExact(hPipe, records.data(), static_cast<size_t>(header.recordCount) * sizeof(T));
+}
+
+HANDLE CreatePipeServer(const char* pipeName) {
+    return CreateNamedPipeA(
+        pipeName,
+        PIPE_ACCESS_OUTBOUND,
+        PIPE_TYPE_BYTE | PIPE_WAIT,
+        1,
+        PIPE_BUFFER_SIZE,
+        PIPE_BUFFER_SIZE,
+        0,
+        NULL
+    );
+}
+
+bool AcceptPipeClient(HANDLE hPipe) {
+    return ConnectNamedPipe(hPipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED;
+}
+
+// Stages are started together, so the server end may not exist yet when a
+// client first tries to connect; keep retrying until the timeout.
+HANDLE OpenPipeClient(const char* pipeName) {
+    const ULONGLONG deadline = GetTickCount64() + PIPE_CONNECT_TIMEOUT_MS;
+    while (true) {
+        HANDLE hPipe = CreateFileA(
+            pipeName,
+            GENERIC_READ,
+            0,
+            NULL,
+            OPEN_EXISTING,
+            0,
+            NULL
+        );
+        if (hPipe != INVALID_HANDLE_VALUE || GetTickCount64() > deadline) {
+            return hPipe;
+        }
+
+        if (GetLastError() == ERROR_PIPE_BUSY) {
+            WaitNamedPipeA(pipeName, PIPE_CONNECT_TIMEOUT_MS);
+        } else if (GetLastError() == ERROR_FILE_NOT_FOUND) {
+            Sleep(1);
+        } else {
+            return hPipe;
+        }
+    }
+}
+
+#endif // DATA_PIPE_PROTOCOL_HPP
@@ -2,66 +2,421 @@
 #define DATA_PIPELINE_LAUNCHER_HPP
 
 #include <windows.h>
+#include <psapi.h>
+#include <algorithm>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
+#include "dataChannel.hpp"
+#include "dataGenerator.hpp"
+#include "externalSort.hpp"
+#include "outputWriter.hpp"
+#include "pipelineStage.hpp"
 
-bool LaunchProcess(const std::string& processName, PROCESS_INFORMATION& pi) {
-    STARTUPINFOA si;
+#pragma comment(lib, "psapi.lib")
+
+// The supervisor waits on a readiness event and a process handle per stage
+// with one WaitForMultipleObjects call, which takes at most 64 handles:
+// generator + output + 30 sorters fill it.
+#define MAX_SORTER_PROCESSES ((MAXIMUM_WAIT_OBJECTS / 2) - 2)
+
+struct PipelineConfig {
+    PipelineTransport transport = PipelineTransport::Pipe;
+    uint64_t recordCount = 100;
+    uint32_t chunkRecords = DEFAULT_CHUNK_RECORDS;
+    Distribution distribution = Distribution::Uniform;
+    uint64_t seed = 1;
+    uint64_t valueRange = 100;
+    OutputFormat outputFormat = OutputFormat::Text;
+    std::string outputPath;
+    bool incrementalSort = false;
+    bool externalSort = false;
+    uint64_t runRecords = DEFAULT_RUN_RECORDS;
+    uint32_t mergeFanIn = DEFAULT_MERGE_FAN_IN;
+    uint32_t sorterCount = 1;       // Sorter processes, each owning one key range.
+    bool mergePartitions = false;   // Merge the sorted partitions instead of concatenating them.
+    DWORD timeoutMs = INFINITE;
+    std::string reportDirectory = ".";  // Where the per-run JSON report goes; empty disables it.
+};
+
+struct StageReport {
+    std::string name;
+    DWORD pid = 0;
+    DWORD exitCode = STILL_ACTIVE;
+    double readySeconds = -1.0;     // Since launch; negative if the stage never signalled.
+    double wallSeconds = 0.0;
+    size_t peakWorkingSetBytes = 0;
+    std::string telemetryJson;      // What the stage wrote to --telemetry; empty if it never did.
+};
+
+struct PipelineReport {
+    std::vector<StageReport> stages;
+    double startupSeconds = 0.0;    // Until the last stage signalled readiness.
+    double wallSeconds = 0.0;
+    bool success = false;
+    std::string reportPath;
+};
+
+// Starts every stage at once and tracks them until they exit. Each child
+// inherits exactly one handle, a manual-reset event it sets through
+// SignalReady() once its channels are connected, so the supervisor can wait
+// on readiness and process exit with a single WaitForMultipleObjects call.
+// If any stage fails or the timeout expires, the remaining stages are
+// terminated instead of being left behind.
+class StageSupervisor {
+public:
+    StageSupervisor();
+    ~StageSupervisor();
+
+    bool launch(const std::string& name, const std::string& arguments);
+    PipelineReport wait(DWORD timeoutMs);
+
+private:
+    struct Stage {
+        StageReport report;
+        PROCESS_INFORMATION pi;
+        HANDLE hReady;
+        std::string telemetryPath;
+        bool ready;
+        bool exited;
+    };
+
+    void collectExit(Stage& stage);
+    void terminateRunning();
+
+    std::vector<Stage> stages;
+    int64_t launchTime;
+};
+
+StageSupervisor::StageSupervisor() : launchTime(PipelineTimestamp()) {}
+
+StageSupervisor::~StageSupervisor() {
+    terminateRunning();
+    for (auto& stage : stages) {
+        CloseHandle(stage.pi.hProcess);
+        CloseHandle(stage.pi.hThread);
+        CloseHandle(stage.hReady);
+    }
+}
+
+bool StageSupervisor::launch(const std::string& name, const std::string& arguments) {
+    SECURITY_ATTRIBUTES inheritable = { sizeof(SECURITY_ATTRIBUTES), NULL, TRUE };
+    HANDLE hReady = CreateEventA(&inheritable, TRUE, FALSE, NULL);
+    if (!hReady) {
+        std::cerr << "CreateEvent failed (" << GetLastError() << ").\n";
+        return false;
+    }
+
+    // Restrict inheritance to this stage's own event so that a sibling's
+    // event is never kept alive by the wrong process.
+    SIZE_T attributeSize = 0;
+    InitializeProcThreadAttributeList(NULL, 1, 0, &attributeSize);
+    std::unique_ptr<char[]> attributeStorage(new char[attributeSize]);
+    auto attributes = reinterpret_cast<LPPROC_THREAD_ATTRIBUTE_LIST>(attributeStorage.get());
+    if (!InitializeProcThreadAttributeList(attributes, 1, 0, &attributeSize) ||
+        !UpdateProcThreadAttribute(attributes, 0, PROC_THREAD_ATTRIBUTE_HANDLE_LIST, &hReady, sizeof(hReady), NULL, NULL)) {
+        std::cerr << "Failed to prepare the handle list (" << GetLastError() << ").\n";
+        CloseHandle(hReady);
+        return false;
+    }
+
+    STARTUPINFOEXA si;
     ZeroMemory(&si, sizeof(si));
-    si.cb = sizeof(si);
+    si.StartupInfo.cb = sizeof(si);
+    si.lpAttributeList = attributes;
+
+    // Each stage leaves its telemetry in a temp file that is collected
+    // once it exits.
+    char tempDir[MAX_PATH];
+    if (!GetTempPathA(MAX_PATH, tempDir)) {
+        tempDir[0] = '\0';
+    }
+    const std::string telemetryPath = std::string(tempDir) + "pipeline_" + std::to_string(GetCurrentProcessId()) +
+                                      "_" + std::to_string(stages.size()) + ".json";
+
+    std::string commandLine = name + arguments + " --ready-handle " + std::to_string(reinterpret_cast<uintptr_t>(hReady)) +
+                              " --telemetry \"" + telemetryPath + "\"";
+    PROCESS_INFORMATION pi;
     ZeroMemory(&pi, sizeof(pi));
 
-    // Start the child process.
-    if (!CreateProcessA(
-            NULL,
-            const_cast<char*>(processName.c_str()),
-            NULL,
-            NULL,
-            FALSE,
-            0,
-            NULL,
-            NULL,
-            &si,
-            &pi
-        )
-    ) {
+    BOOL created = CreateProcessA(
+        NULL,
+        const_cast<char*>(commandLine.c_str()),
+        NULL,
+        NULL,
+        TRUE,
+        EXTENDED_STARTUPINFO_PRESENT,
+        NULL,
+        NULL,
+        &si.StartupInfo,
+        &pi
+    );
+    DeleteProcThreadAttributeList(attributes);
+
+    if (!created) {
         std::cerr << "CreateProcess failed (" << GetLastError() << ").\n";
+        CloseHandle(hReady);
         return false;
     }
 
-    std::cout << "Launched " << processName << " with pid " << pi.dwProcessId << std::endl;
+    std::cout << "Launched " << name << " with pid " << pi.dwProcessId << std::endl;
+    Stage stage = { StageReport(), pi, hReady, telemetryPath, false, false };
+    stage.report.name = name;
+    stage.report.pid = pi.dwProcessId;
+    stages.push_back(stage);
     return true;
 }
 
-void LaunchDataPipeline() {
-    std::vector<PROCESS_INFORMATION> processes(3);
+void StageSupervisor::collectExit(Stage& stage) {
+    stage.exited = true;
+    GetExitCodeProcess(stage.pi.hProcess, &stage.report.exitCode);
+
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(stage.pi.hProcess, &creationTime, &exitTime, &kernelTime, &userTime)) {
+        ULARGE_INTEGER created, exited;
+        created.LowPart = creationTime.dwLowDateTime;
+        created.HighPart = creationTime.dwHighDateTime;
+        exited.LowPart = exitTime.dwLowDateTime;
+        exited.HighPart = exitTime.dwHighDateTime;
+        stage.report.wallSeconds = static_cast<double>(exited.QuadPart - created.QuadPart) / 1e7;
+    }
 
-    if (!LaunchProcess("dataGeneration.exe", processes[0])) {
-        std::cerr << "Failed to launch dataGeneration.exe\n";
-        return;
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(stage.pi.hProcess, &counters, sizeof(counters))) {
+        stage.report.peakWorkingSetBytes = counters.PeakWorkingSetSize;
     }
 
-    Sleep(500);
+    std::ifstream telemetry(stage.telemetryPath);
+    if (telemetry) {
+        std::getline(telemetry, stage.report.telemetryJson);
+        telemetry.close();
+        DeleteFileA(stage.telemetryPath.c_str());
+    }
+}
 
-    if (!LaunchProcess("dataSorting.exe", processes[1])) {
-        std::cerr << "Failed to launch dataSorting.exe\n";
-        return;
+void StageSupervisor::terminateRunning() {
+    for (auto& stage : stages) {
+        if (!stage.exited) {
+            TerminateProcess(stage.pi.hProcess, 1);
+            WaitForSingleObject(stage.pi.hProcess, INFINITE);
+            collectExit(stage);
+        }
     }
+}
+
+PipelineReport StageSupervisor::wait(DWORD timeoutMs) {
+    PipelineReport result;
+    result.success = true;
+    const ULONGLONG deadline = timeoutMs == INFINITE ? 0 : GetTickCount64() + timeoutMs;
+
+    while (true) {
+        std::vector<HANDLE> handles;
+        std::vector<std::pair<Stage*, bool>> owners; // (stage, is readiness event)
+        for (auto& stage : stages) {
+            if (!stage.ready && !stage.exited) {
+                handles.push_back(stage.hReady);
+                owners.emplace_back(&stage, true);
+            }
+            if (!stage.exited) {
+                handles.push_back(stage.pi.hProcess);
+                owners.emplace_back(&stage, false);
+            }
+        }
+        if (handles.empty()) break;
+
+        DWORD waitMs = INFINITE;
+        if (deadline != 0) {
+            ULONGLONG now = GetTickCount64();
+            waitMs = now >= deadline ? 0 : static_cast<DWORD>(deadline - now);
+        }
+
+        DWORD signalled = WaitForMultipleObjects(static_cast<DWORD>(handles.size()), handles.data(), FALSE, waitMs);
+        if (signalled == WAIT_TIMEOUT || signalled == WAIT_FAILED) {
+            std::cerr << (signalled == WAIT_TIMEOUT ? "Pipeline timed out" : "Waiting for the pipeline failed")
+                      << ", terminating remaining stages.\n";
+            result.success = false;
+            terminateRunning();
+            break;
+        }
+
+        auto [stage, isReadiness] = owners[signalled - WAIT_OBJECT_0];
+        if (isReadiness) {
+            stage->ready = true;
+            stage->report.readySeconds = PipelineSeconds(launchTime, PipelineTimestamp());
+            continue;
+        }
+
+        collectExit(*stage);
+        if (stage->report.exitCode != 0) {
+            std::cerr << stage->report.name << " failed with exit code " << stage->report.exitCode
+                      << ", terminating remaining stages.\n";
+            result.success = false;
+            terminateRunning();
+            break;
+        }
+    }
+
+    result.wallSeconds = PipelineSeconds(launchTime, PipelineTimestamp());
+    for (auto& stage : stages) {
+        result.startupSeconds = std::max(result.startupSeconds, stage.report.readySeconds);
+        result.success = result.success && stage.report.exitCode == 0;
+        result.stages.push_back(stage.report);
+    }
+    return result;
+}
+
+// One JSON document per run: the configuration, the supervisor's view of
+// every stage and the telemetry each stage reported about itself, so runs
+// can be compared over time.
+std::string PipelineReportJson(const PipelineConfig& config, const PipelineReport& report) {
+    std::ostringstream json;
+    json << "{\"timestamp\": " << static_cast<long long>(std::time(nullptr))
+         << ", \"success\": " << (report.success ? "true" : "false")
+         << ", \"wall_s\": " << report.wallSeconds
+         << ", \"startup_s\": " << report.startupSeconds
+         << ",\n \"config\": {\"transport\": \"" << TransportName(config.transport) << "\""
+         << ", \"records\": " << config.recordCount
+         << ", \"chunk_records\": " << config.chunkRecords
+         << ", \"distribution\": \"" << DistributionName(config.distribution) << "\""
+         << ", \"seed\": " << config.seed
+         << ", \"value_range\": " << config.valueRange
+         << ", \"output_format\": \"" << OutputFormatName(config.outputFormat) << "\""
+         << ", \"sort\": \"" << (config.externalSort ? "external" : config.incrementalSort ? "incremental" : "in-memory") << "\""
+         << ", \"sorters\": " << config.sorterCount
+         << ", \"merge_partitions\": " << (config.mergePartitions ? "true" : "false") << "}"
+         << ",\n \"stages\": [";
+    for (size_t i = 0; i < report.stages.size(); ++i) {
+        const StageReport& stage = report.stages[i];
+        json << (i ? "," : "") << "\n  {\"name\": \"" << stage.name << "\""
+             << ", \"pid\": " << stage.pid
+             << ", \"exit_code\": " << stage.exitCode
+             << ", \"ready_s\": " << stage.readySeconds
+             << ", \"wall_s\": " << stage.wallSeconds
+             << ", \"peak_working_set_bytes\": " << stage.peakWorkingSetBytes
+             << ", \"telemetry\": " << (stage.telemetryJson.empty() ? "null" : stage.telemetryJson) << "}";
+    }
+    json << "\n]}\n";
+    return json.str();
+}
+
+bool WritePipelineReport(const PipelineConfig& config, PipelineReport& report) {
+    if (config.reportDirectory.empty()) return true;
+
+    // Runs started within the same second (a sorter sweep) would share the
+    // timestamp, so the name also carries the pid and a sequence number, and
+    // the file is claimed with CREATE_NEW so no earlier report is replaced.
+    static uint32_t sequence = 0;
+    char stamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    for (;;) {
+        report.reportPath = config.reportDirectory + "\\pipeline_" + stamp + "_" + std::to_string(GetCurrentProcessId()) +
+                            "_" + std::to_string(sequence++) + ".json";
+        HANDLE hReport = CreateFileA(report.reportPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hReport != INVALID_HANDLE_VALUE) {
+            CloseHandle(hReport);
+            break;
+        }
+        if (GetLastError() != ERROR_FILE_EXISTS) {
+            std::cerr << "Failed to create the pipeline report " << report.reportPath << " (" << GetLastError() << ").\n";
+            report.reportPath.clear();
+            return false;
+        }
+    }
+
+    std::ofstream file(report.reportPath, std::ios::trunc);
+    file << PipelineReportJson(config, report);
+    if (!file) {
+        std::cerr << "Failed to write the pipeline report to " << report.reportPath << ".\n";
+        report.reportPath.clear();
+        return false;
+    }
+    return true;
+}
+
+PipelineReport LaunchDataPipeline(const PipelineConfig& config = {}) {
+    StageSupervisor supervisor;
+    const uint32_t sorters = std::clamp<uint32_t>(config.sorterCount, 1, MAX_SORTER_PROCESSES);
+    const std::string chunkArgs = " --chunk-records " + std::to_string(config.chunkRecords) +
+                                  " --transport " + TransportName(config.transport) +
+                                  " --partitions " + std::to_string(sorters) +
+                                  " --epoch " + std::to_string(PipelineTimestamp());
+
+    std::string sortingArgs = chunkArgs;
+    if (config.externalSort) {
+        sortingArgs += " --external --run-records " + std::to_string(config.runRecords) +
+                       " --fan-in " + std::to_string(config.mergeFanIn);
+    } else if (config.incrementalSort) {
+        sortingArgs += " --incremental";
+    }
+    if (sorters > 1) {
+        sortingArgs += " --threads " + std::to_string(std::max(1u, std::thread::hardware_concurrency() / sorters));
+    }
+
+    std::string outputArgs = std::string(" --format ") + OutputFormatName(config.outputFormat);
+    if (!config.outputPath.empty()) {
+        outputArgs += " --output \"" + config.outputPath + "\"";
+    }
+    if (config.mergePartitions) {
+        outputArgs += " --merge";
+    }
+
+    // All stages start together; the consumers retry until their producer
+    // has created its endpoint, so no start-up delays are needed.
+    const std::string generationArgs = " --records " + std::to_string(config.recordCount) +
+                                       " --distribution " + DistributionName(config.distribution) +
+                                       " --seed " + std::to_string(config.seed) +
+                                       " --range " + std::to_string(config.valueRange);
+
+    bool launched = supervisor.launch("dataGeneration.exe", generationArgs + chunkArgs);
+    for (uint32_t partition = 0; launched && partition < sorters; ++partition) {
+        launched = supervisor.launch("dataSorting.exe", sortingArgs + " --partition " + std::to_string(partition));
+    }
+    if (!launched || !supervisor.launch("dataOutput.exe", outputArgs + chunkArgs)) {
+        std::cerr << "Failed to launch the data pipeline\n";
+        return supervisor.wait(0);
+    }
+
+    PipelineReport report = supervisor.wait(config.timeoutMs);
+    std::cout << "Pipeline " << (report.success ? "completed" : "failed") << " in " << report.wallSeconds
+              << " s (startup " << report.startupSeconds * 1000.0 << " ms)." << std::endl;
+    for (const auto& stage : report.stages) {
+        std::cout << "  " << stage.name << ": exit " << stage.exitCode << ", ready after "
+                  << stage.readySeconds * 1000.0 << " ms, wall " << stage.wallSeconds
+                  << " s, peak RSS " << stage.peakWorkingSetBytes / 1024 << " KiB" << std::endl;
+    }
+    if (WritePipelineReport(config, report) && !report.reportPath.empty()) {
+        std::cout << "Report written to " << report.reportPath << std::endl;
+    }
+    return report;
+}
 
-    Sleep(500);
+struct ScalingPoint {
+    uint32_t sorters = 0;
+    double wallSeconds = 0.0;
+    bool success = false;
+};
 
-    if (!LaunchProcess("dataOutput.exe", processes[2])) {
-        std::cerr << "Failed to launch dataOutput.exe\n";
-        return;
+// Runs the same pipeline with 1..maxSorters sorter processes (all cores by
+// default) to measure how sorting scales with the process count.
+std::vector<ScalingPoint> RunSorterScalingSweep(PipelineConfig config, uint32_t maxSorters = 0) {
+    if (maxSorters == 0) {
+        maxSorters = std::max(1u, std::thread::hardware_concurrency());
     }
+    maxSorters = std::min<uint32_t>(maxSorters, MAX_SORTER_PROCESSES);
 
-    // Wait for all processes to complete
-    for (const auto& pi : processes) {
-        WaitForSingleObject(pi.hProcess, 1000);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
+    std::vector<ScalingPoint> points;
+    for (uint32_t sorters = 1; sorters <= maxSorters; ++sorters) {
+        config.sorterCount = sorters;
+        const PipelineReport report = LaunchDataPipeline(config);
+        points.push_back({ sorters, report.wallSeconds, report.success });
     }
+    return points;
 }
 
-#endif // DATA_PIPELINE_LAUNCHER_HPP
\ No newline at end of file
+#endif // DATA_PIPELINE_LAUNCHER_HPP
@@ -1,61 +1,129 @@
 #include <windows.h>
 #include <iostream>
+#include <optional>
 #include <vector>
 #include <algorithm>
+#include "dataChannel.hpp"
+#include "externalSort.hpp"
+#include "incrementalSort.hpp"
+#include "pipelineStage.hpp"
+#include "radixSort.hpp"
+#include "stageTelemetry.hpp"
 
-#define IN_PIPE_NAME "\\\\.\\pipe\\DataPipe"
-#define OUT_PIPE_NAME "\\\\.\\pipe\\SortedPipe"
-#define BUFFER_SIZE 1024
-
-int main() {
-    HANDLE hInputPipe = CreateFileA(
-        IN_PIPE_NAME,
-        GENERIC_READ,
-        0,
-        NULL,
-        OPEN_EXISTING,
-        0,
-        NULL
-    );
-
-    if (hInputPipe == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to open input pipe." << std::endl;
+int main(int argc, char** argv) {
+    StageArgs args(argc, argv);
+    const int64_t epoch = PipelineEpoch(args);
+    const uint64_t chunkRecords = args.getSize("--chunk-records", DEFAULT_CHUNK_RECORDS);
+    const bool external = args.has("--external");
+    const bool incremental = !external && args.has("--incremental");
+    const uint64_t runRecords = args.getSize("--run-records", DEFAULT_RUN_RECORDS);
+    const uint64_t fanIn = args.getSize("--fan-in", DEFAULT_MERGE_FAN_IN);
+    const std::string transportName = args.getString("--transport", "pipe");
+    PipelineTransport transport;
+    if (!ParseTransport(transportName, transport)) {
+        std::cerr << "Unknown transport " << transportName << "; use pipe or ring." << std::endl;
         return 1;
     }
-    std::cout << "Receiving data from the generator..." << std::endl;
+    const uint32_t partitions = static_cast<uint32_t>(std::max<uint64_t>(args.getSize("--partitions", 1), 1));
+    const uint32_t partition = static_cast<uint32_t>(args.getSize("--partition", 0));
+    // Sorter processes running side by side split the cores between them.
+    const unsigned threads = static_cast<unsigned>(args.getSize("--threads", 0));
+
+    if (chunkRecords == 0 || chunkRecords > UINT32_MAX) {
+        std::cerr << "Invalid chunk size." << std::endl;
+        return 1;
+    }
+
+    auto input = OpenConsumerChannel<int32_t>(transport, PartitionChannelName("DataPipe", partition, partitions), static_cast<size_t>(chunkRecords));
 
-    std::vector<int> data(100);
-    DWORD bytesRead;
-    ReadFile(hInputPipe, data.data(), data.size() * sizeof(int), &bytesRead, NULL);
-    CloseHandle(hInputPipe);
-
-    std::sort(data.begin(), data.end());
-
-    HANDLE hOutputPipe = CreateNamedPipeA(
-        OUT_PIPE_NAME,
-        PIPE_ACCESS_OUTBOUND,
-        PIPE_TYPE_BYTE | PIPE_WAIT,
-        1,
-        BUFFER_SIZE,
-        BUFFER_SIZE,
-        0,
-        NULL
-    );
-
-    if (hOutputPipe == INVALID_HANDLE_VALUE) {
-        std::cerr << "Failed to create output pipe." << std::endl;
+    if (!input) {
+        std::cerr << "Failed to open input channel." << std::endl;
         return 1;
     }
+
+    // The output side is set up before any input arrives so that the output
+    // stage connects while we are still receiving, not after the sort.
     std::cout << "Waiting for the output process to connect..." << std::endl;
+    auto output = CreateProducerChannel<int32_t>(transport, PartitionChannelName("SortedPipe", partition, partitions), static_cast<size_t>(chunkRecords));
 
-    if (ConnectNamedPipe(hOutputPipe, NULL) || GetLastError() == ERROR_PIPE_CONNECTED) {
-        DWORD bytesWritten;
-        WriteFile(hOutputPipe, data.data(), data.size() * sizeof(int), &bytesWritten, NULL);
-    } else {
+    if (!output) {
         std::cerr << "Failed to connect to the output process." << std::endl;
+        return 1;
     }
+    SignalReady(args);
+    StageTelemetry telemetry(PartitionChannelName("sorting", partition, partitions), args);
+    std::cout << "Receiving data from the generator..." << std::endl;
 
-    CloseHandle(hOutputPipe);
+    // In external mode incoming chunks are only buffered up to runRecords
+    // before being spilled, so memory stays bounded for any input size.
+    // In incremental mode every chunk is handed to a sorting worker as soon
+    // as it arrives.
+    std::vector<int32_t> data;
+    ExternalSorter<int32_t> externalSorter(external ? static_cast<size_t>(runRecords) : 1, static_cast<size_t>(fanIn), args.getString("--temp-dir", ""));
+    // Only incremental mode gets sorting workers; the other modes never hand
+    // chunks off.
+    std::optional<IncrementalSorter<int32_t>> incrementalSorter;
+    if (incremental) {
+        incrementalSorter.emplace(static_cast<unsigned>(args.getSize("--sort-workers", threads)));
+    }
+    FrameHeader header;
+    const int32_t* records = nullptr;
+    bool endOfStream = false;
+    while (!endOfStream) {
+        telemetry.sampleQueueDepth(input->queuedFrames());
+        const int64_t readStart = PipelineTimestamp();
+        if (!input->acquireRead(header, records)) {
+            std::cerr << "Input stream ended without an end-of-stream frame." << std::endl;
+            return 1;
+        }
+        const int64_t received = PipelineTimestamp();
+        if (external) {
+            if (!externalSorter.add(records, header.recordCount)) {
+                return 1;
+            }
+        } else if (incremental) {
+            incrementalSorter->add(records, header.recordCount);
+        } else {
+            data.insert(data.end(), records, records + header.recordCount);
+        }
+        telemetry.addReadBlocked(PipelineSeconds(readStart, received));
+        telemetry.addChunkLatency(PipelineSeconds(received, PipelineTimestamp()));
+        telemetry.addRecords(header.recordCount, header.recordCount * sizeof(int32_t));
+        endOfStream = (header.flags & FRAME_FLAG_END_OF_STREAM) != 0;
+        input->releaseRead();
+    }
+    input.reset();
+    const int64_t inputDone = PipelineTimestamp();
+
+    if (external) {
+        std::cout << "Spilled " << externalSorter.spilledRuns() << " sorted runs ("
+                  << externalSorter.spilledBytes() << " bytes)." << std::endl;
+    } else if (!incremental) {
+        SortKeys(data.data(), data.size(), threads);
+    }
+
+    int64_t firstOutput = 0;
+    auto emit = [&output, &firstOutput, &telemetry](const int32_t* records, size_t count) {
+        const int64_t start = PipelineTimestamp();
+        if (firstOutput == 0) firstOutput = start;
+        const bool ok = output->write(records, count);
+        telemetry.addWriteBlocked(PipelineSeconds(start, PipelineTimestamp()));
+        return ok;
+    };
+
+    bool written = external ? externalSorter.finish(static_cast<size_t>(chunkRecords), emit)
+                 : incremental ? incrementalSorter->finish(static_cast<size_t>(chunkRecords), emit)
+                 : emit(data.data(), data.size());
+    const bool delivered = written && output->acquireWrite() && output->commitWrite(0, FRAME_FLAG_END_OF_STREAM) && output->close();
+    if (!delivered) {
+        std::cerr << "Failed to write sorted data to the output channel." << std::endl;
+    }
+
+    if (firstOutput != 0) {
+        std::cout << "Input complete at " << PipelineSeconds(epoch, inputDone) << " s, first sorted output after "
+                  << PipelineSeconds(inputDone, firstOutput) << " s." << std::endl;
+    }
+    telemetry.write();
     std::cout << "Data sorting process completed." << std::endl;
-    return 0;
-}
\ No newline at end of file
+    return delivered ? 0 : 1;
+}
@@ -0,0 +1,200 @@
+#ifndef DATASET_FORMAT_HPP
+#define DATASET_FORMAT_HPP
+
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "dataPipeProtocol.hpp"
+
+#define DATASET_MAGIC 0x54455344 // "DSET"
+#define DATASET_VERSION 1
+// The payload starts on an allocation-granularity boundary so it can be
+// mapped on its own, which also keeps it sector-aligned for unbuffered reads.
+#define DATASET_PAYLOAD_ALIGNMENT (64 * 1024)
+#define DEFAULT_DATASET_BLOCK_BYTES (4 * 1024 * 1024)
+// Checksum verification allocates one block, so the header may not ask for more.
+#define MAX_DATASET_BLOCK_BYTES (1024ull * 1024 * 1024)
+
+enum DatasetFlags : uint32_t {
+    DATASET_FLAG_NONE = 0,
+    DATASET_FLAG_CHECKSUMS = 1,
+};
+
+// A dataset file is this header, zero padding up to payloadOffset, count
+// elements of elementType, and, with DATASET_FLAG_CHECKSUMS, one 64-bit
+// checksum per blockBytes of payload at checksumOffset. Distribution and
+// seed only record how the data was generated.
+struct DatasetHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerBytes;
+    uint32_t elementType;
+    uint32_t elementBytes;
+    uint64_t count;
+    uint64_t payloadOffset;
+    uint32_t flags;
+    uint32_t distribution;
+    uint64_t blockBytes;
+    uint64_t checksumOffset;
+    uint64_t seed;
+};
+
+static_assert(sizeof(DatasetHeader) == 64, "DatasetHeader is part of the file format");
+
+const char* ElementTypeName(ElementType type) {
+    switch (type) {
+    case ElementType::Int32: return "int32";
+    case ElementType::Int64: return "int64";
+    case ElementType::Float32: return "float";
+    case ElementType::Float64: return "double";
+    case ElementType::Record16: return "record16";
+    case ElementType::Record64: return "record64";
+    case ElementType::Record128: return "record128";
+    }
+    return "int32";
+}
+
+// Returns false for names ElementTypeName() never produces.
+bool ParseElementType(const std::string& name, ElementType& type) {
+    for (ElementType candidate : { ElementType::Int32, ElementType::Int64, ElementType::Float32, ElementType::Float64,
+                                   ElementType::Record16, ElementType::Record64, ElementType::Record128 }) {
+        if (name == ElementTypeName(candidate)) {
+            type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t DatasetPayloadBytes(const DatasetHeader& header) {
+    return header.count * header.elementBytes;
+}
+
+uint64_t DatasetBlockCount(const DatasetHeader& header) {
+    return header.blockBytes ? (DatasetPayloadBytes(header) + header.blockBytes - 1) / header.blockBytes : 0;
+}
+
+DatasetHeader MakeDatasetHeader(ElementType type, uint64_t count, uint64_t blockBytes, bool checksums) {
+    DatasetHeader header = {};
+    header.magic = DATASET_MAGIC;
+    header.version = DATASET_VERSION;
+    header.headerBytes = sizeof(DatasetHeader);
+    header.elementType = static_cast<uint32_t>(type);
+    header.elementBytes = static_cast<uint32_t>(ElementSize(type));
+    header.count = count;
+    header.payloadOffset = DATASET_PAYLOAD_ALIGNMENT;
+    header.flags = checksums ? DATASET_FLAG_CHECKSUMS : DATASET_FLAG_NONE;
+    header.blockBytes = blockBytes;
+    header.checksumOffset = checksums ? (header.payloadOffset + DatasetPayloadBytes(header) + 7) / 8 * 8 : 0;
+    return header;
+}
+
+// FNV-1a over 64-bit words (bytes for the tail): cheap enough to keep up
+// with the generator, good enough to catch torn or truncated blocks.
+uint64_t DatasetChecksum(const void* data, size_t bytes) {
+    const char* cursor = static_cast<const char*>(data);
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (; bytes >= sizeof(uint64_t); cursor += sizeof(uint64_t), bytes -= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, cursor, sizeof(word));
+        hash = (hash ^ word) * 0x100000001B3ull;
+    }
+    for (; bytes > 0; ++cursor, --bytes) {
+        hash = (hash ^ static_cast<unsigned char>(*cursor)) * 0x100000001B3ull;
+    }
+    return hash;
+}
+
+bool ReadAt(HANDLE hFile, uint64_t offset, void* data, size_t size) {
+    char* cursor = static_cast<char*>(data);
+    while (size > 0) {
+        OVERLAPPED position = {};
+        position.Offset = static_cast<DWORD>(offset);
+        position.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        if (!ReadFile(hFile, cursor, static_cast<DWORD>(std::min<size_t>(size, 1 << 30)), &read, &position) || read == 0) {
+            return false;
+        }
+        cursor += read;
+        offset += read;
+        size -= read;
+    }
+    return true;
+}
+
+// Reads the header and checks that it describes a file of this size; the
+// payload is only trusted after this succeeds.
+bool ReadDatasetHeader(HANDLE hFile, const std::string& path, DatasetHeader& header) {
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || !ReadAt(hFile, 0, &header, sizeof(header))) {
+        std::cerr << path << " is too short to be a dataset.\n";
+        return false;
+    }
+    if (header.magic != DATASET_MAGIC) {
+        std::cerr << path << " is not a dataset (magic " << std::hex << header.magic << std::dec << "); create one with datasetGenerator.\n";
+        return false;
+    }
+    if (header.version != DATASET_VERSION || header.headerBytes != sizeof(DatasetHeader)) {
+        std::cerr << path << " has unsupported dataset version " << header.version << ".\n";
+        return false;
+    }
+    if (header.elementBytes == 0 || ElementSize(static_cast<ElementType>(header.elementType)) != header.elementBytes) {
+        std::cerr << path << " has unknown element type " << header.elementType << ".\n";
+        return false;
+    }
+    if (header.payloadOffset < sizeof(DatasetHeader) || header.payloadOffset % DATASET_PAYLOAD_ALIGNMENT != 0) {
+        std::cerr << path << " has a misaligned payload offset " << header.payloadOffset << ".\n";
+        return false;
+    }
+
+    // Sizes are checked against what is left of the file rather than summed,
+    // so a corrupt count or offset cannot overflow into a passing check.
+    const uint64_t fileBytes = static_cast<uint64_t>(fileSize.QuadPart);
+    if (header.payloadOffset > fileBytes || header.count > (fileBytes - header.payloadOffset) / header.elementBytes) {
+        std::cerr << path << " is truncated: " << fileBytes << " bytes cannot hold " << header.count << " elements of "
+                  << header.elementBytes << " bytes at offset " << header.payloadOffset << ".\n";
+        return false;
+    }
+    if (header.flags & DATASET_FLAG_CHECKSUMS) {
+        const uint64_t payloadEnd = header.payloadOffset + DatasetPayloadBytes(header);
+        if (header.blockBytes == 0 || header.blockBytes > MAX_DATASET_BLOCK_BYTES || header.checksumOffset < payloadEnd) {
+            std::cerr << path << " has an invalid checksum table.\n";
+            return false;
+        }
+        if (header.checksumOffset > fileBytes || DatasetBlockCount(header) > (fileBytes - header.checksumOffset) / sizeof(uint64_t)) {
+            std::cerr << path << " is truncated: " << fileBytes << " bytes cannot hold its checksum table.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rereads the whole payload; only worth it once per file, not per run.
+bool VerifyDatasetChecksums(HANDLE hFile, const std::string& path, const DatasetHeader& header) {
+    if (!(header.flags & DATASET_FLAG_CHECKSUMS)) {
+        return true;
+    }
+    const uint64_t blocks = DatasetBlockCount(header);
+    std::unique_ptr<uint64_t[]> checksums(new uint64_t[blocks]);
+    std::unique_ptr<char[]> buffer(new char[header.blockBytes]);
+    if (!ReadAt(hFile, header.checksumOffset, checksums.get(), blocks * sizeof(uint64_t))) {
+        std::cerr << "Failed to read the checksums of " << path << ".\n";
+        return false;
+    }
+    const uint64_t payloadBytes = DatasetPayloadBytes(header);
+    for (uint64_t block = 0; block < blocks; ++block) {
+        const uint64_t offset = block * header.blockBytes;
+        const size_t bytes = static_cast<size_t>(std::min<uint64_t>(header.blockBytes, payloadBytes - offset));
+        if (!ReadAt(hFile, header.payloadOffset + offset, buffer.get(), bytes) || DatasetChecksum(buffer.get(), bytes) != checksums[block]) {
+            std::cerr << path << " is corrupt: block " << block << " fails its checksum.\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif // DATASET_FORMAT_HPP
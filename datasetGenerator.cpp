@@ -0,0 +1,122 @@
+#include <windows.h>
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "dataGenerator.hpp"
+#include "datasetFormat.hpp"
+#include "pipelineStage.hpp"
+
+// Records get generated keys; the first eight payload bytes hold the
+// record's index so a sorted copy can be checked for stability.
+template <typename T>
+void FillBlock(const DataGenerator& generator, T* block, uint64_t firstIndex, size_t count, std::vector<int64_t>& keys) {
+    if constexpr (std::is_arithmetic_v<T>) {
+        generator.fill(block, firstIndex, count);
+    } else {
+        keys.resize(count);
+        generator.fill(keys.data(), firstIndex, count);
+        for (size_t i = 0; i < count; ++i) {
+            const uint64_t index = firstIndex + i;
+            block[i].key = keys[i];
+            std::memset(block[i].payload, 0, sizeof(block[i].payload));
+            std::memcpy(block[i].payload, &index, sizeof(index));
+        }
+    }
+}
+
+// Writes the payload block by block; while one block is written the next
+// is already being generated into the other buffer.
+template <typename T>
+bool WritePayload(HANDLE hFile, const DataGenerator& generator, const DatasetHeader& header, std::vector<uint64_t>& checksums) {
+    const size_t blockRecords = static_cast<size_t>(header.blockBytes / sizeof(T));
+    std::vector<T> buffers[2] = { std::vector<T>(blockRecords), std::vector<T>(blockRecords) };
+    std::vector<int64_t> keys;
+    std::future<bool> pendingWrite;
+    int current = 0;
+
+    for (uint64_t written = 0; written < header.count; written += blockRecords, current ^= 1) {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(blockRecords, header.count - written));
+        T* block = buffers[current].data();
+        FillBlock(generator, block, written, count, keys);
+        if (header.flags & DATASET_FLAG_CHECKSUMS) {
+            checksums.push_back(DatasetChecksum(block, count * sizeof(T)));
+        }
+        if (pendingWrite.valid() && !pendingWrite.get()) {
+            return false;
+        }
+        pendingWrite = std::async(std::launch::async, WriteExact, hFile, static_cast<const void*>(block), count * sizeof(T));
+    }
+    return !pendingWrite.valid() || pendingWrite.get();
+}
+
+int main(int argc, char** argv) {
+    StageArgs args(argc, argv);
+    const std::string outputPath = args.getString("--output", "data.bin");
+    const uint64_t recordCount = args.getSize("--records", 1000000);
+    const std::string typeName = args.getString("--type", "int32");
+    const uint64_t blockBytes = args.getSize("--block-bytes", DEFAULT_DATASET_BLOCK_BYTES);
+    const bool checksums = !args.has("--no-checksums");
+
+    ElementType type;
+    if (!ParseElementType(typeName, type)) {
+        std::cerr << "Unknown element type " << typeName << "; use int32, int64, float, double, record16, record64 or record128." << std::endl;
+        return 1;
+    }
+
+    if (blockBytes < ElementSize(type) || blockBytes % ElementSize(type) != 0) {
+        std::cerr << "The block size must be a multiple of the element size." << std::endl;
+        return 1;
+    }
+    if (blockBytes > MAX_DATASET_BLOCK_BYTES) {
+        std::cerr << "The block size may be at most " << MAX_DATASET_BLOCK_BYTES << " bytes." << std::endl;
+        return 1;
+    }
+
+    GeneratorConfig generatorConfig;
+    if (!ParseGeneratorConfig(args, recordCount, generatorConfig)) {
+        return 1;
+    }
+    const DataGenerator generator(generatorConfig, static_cast<unsigned>(args.getSize("--threads", 0)));
+    DatasetHeader header = MakeDatasetHeader(type, recordCount, blockBytes, checksums);
+    header.distribution = static_cast<uint32_t>(generator.getConfig().distribution);
+    header.seed = generator.getConfig().seed;
+
+    HANDLE hFile = CreateFileA(outputPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to create " << outputPath << "." << std::endl;
+        return 1;
+    }
+
+    std::cout << "Writing " << recordCount << " " << DistributionName(generator.getConfig().distribution) << " "
+              << ElementTypeName(type) << " records to " << outputPath << "..." << std::endl;
+    auto start = std::chrono::high_resolution_clock::now();
+
+    std::vector<char> prefix(static_cast<size_t>(header.payloadOffset), 0);
+    std::memcpy(prefix.data(), &header, sizeof(header));
+    std::vector<uint64_t> blockChecksums;
+    bool ok = WriteExact(hFile, prefix.data(), prefix.size()) && VisitElementType(type, [&](auto element) {
+        return WritePayload<typename decltype(element)::type>(hFile, generator, header, blockChecksums);
+    });
+    if (ok && checksums) {
+        const std::vector<char> padding(static_cast<size_t>(header.checksumOffset - header.payloadOffset - DatasetPayloadBytes(header)), 0);
+        ok = WriteExact(hFile, padding.data(), padding.size()) &&
+             WriteExact(hFile, blockChecksums.data(), blockChecksums.size() * sizeof(uint64_t));
+    }
+    CloseHandle(hFile);
+    if (!ok) {
+        std::cerr << "Failed to write " << outputPath << "." << std::endl;
+        DeleteFileA(outputPath.c_str());
+        return 1;
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double bytes = static_cast<double>(DatasetPayloadBytes(header));
+    std::cout << "Wrote " << bytes / (1024 * 1024) << " MiB in " << seconds << " seconds ("
+              << (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MiB/s)." << std::endl;
+    return 0;
+}
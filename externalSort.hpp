@@ -0,0 +1,369 @@
+#ifndef EXTERNAL_SORT_HPP
+#define EXTERNAL_SORT_HPP
+
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "radixSort.hpp"
+
+#define DEFAULT_RUN_RECORDS (16 * 1024 * 1024)
+#define DEFAULT_MERGE_FAN_IN 16
+#define MIN_MERGE_BUFFER_RECORDS 4096
+
+// Tournament tree of losers over k sorted sources. Each source exposes its
+// current head as a pointer; nullptr marks an exhausted source. Replacing
+// the winner's head costs one leaf-to-root pass of log2(k) comparisons.
+template <typename T>
+class LoserTree {
+public:
+    explicit LoserTree(size_t sourceCount);
+
+    void setHead(size_t source, const T* head) { heads[source] = head; }
+    void build();
+    void replaceWinner(const T* head);
+
+    size_t winner() const { return tree[0]; }
+    bool empty() const { return heads[tree[0]] == nullptr; }
+    const T& top() const { return *heads[tree[0]]; }
+
+private:
+    bool beats(size_t a, size_t b) const;
+    void adjust(size_t source);
+
+    size_t sourceCount;
+    std::vector<size_t> tree;
+    std::vector<const T*> heads;
+};
+
+template <typename T>
+LoserTree<T>::LoserTree(size_t sourceCount)
+    : sourceCount(sourceCount), tree(std::max<size_t>(sourceCount, 1)), heads(sourceCount, nullptr) {}
+
+// Index sourceCount is a virtual leaf that beats everything; it seeds the
+// tree so that build() can insert the real sources one by one. Equal heads
+// go to the lower source index, which keeps the merge stable.
+template <typename T>
+bool LoserTree<T>::beats(size_t a, size_t b) const {
+    if (a == sourceCount) return b != sourceCount;
+    if (b == sourceCount) return false;
+    if (heads[a] == nullptr) return false;
+    if (heads[b] == nullptr) return true;
+    if (*heads[a] < *heads[b]) return true;
+    if (*heads[b] < *heads[a]) return false;
+    return a < b;
+}
+
+template <typename T>
+void LoserTree<T>::adjust(size_t source) {
+    for (size_t node = (source + sourceCount) / 2; node > 0; node /= 2) {
+        if (beats(tree[node], source)) {
+            std::swap(source, tree[node]);
+        }
+    }
+    tree[0] = source;
+}
+
+template <typename T>
+void LoserTree<T>::build() {
+    std::fill(tree.begin(), tree.end(), sourceCount);
+    for (size_t source = sourceCount; source-- > 0;) {
+        adjust(source);
+    }
+}
+
+template <typename T>
+void LoserTree<T>::replaceWinner(const T* head) {
+    heads[tree[0]] = head;
+    adjust(tree[0]);
+}
+
+// A sorted run spilled to a temporary file that is deleted on close.
+class RunFile {
+public:
+    RunFile() = default;
+    RunFile(const RunFile&) = delete;
+    RunFile& operator=(const RunFile&) = delete;
+    ~RunFile();
+
+    bool create(const std::string& directory);
+    bool append(const void* data, size_t size);
+    bool rewind();
+    bool read(void* data, size_t size);
+
+    uint64_t size() const { return bytesWritten; }
+
+private:
+    HANDLE hFile = INVALID_HANDLE_VALUE;
+    uint64_t bytesWritten = 0;
+};
+
+RunFile::~RunFile() {
+    if (hFile != INVALID_HANDLE_VALUE) {
+        CloseHandle(hFile);
+    }
+}
+
+bool RunFile::create(const std::string& directory) {
+    char tempDir[MAX_PATH];
+    char tempPath[MAX_PATH];
+    if (directory.empty()) {
+        if (GetTempPathA(MAX_PATH, tempDir) == 0) return false;
+    } else {
+        strncpy(tempDir, directory.c_str(), MAX_PATH - 1);
+        tempDir[MAX_PATH - 1] = '\0';
+    }
+    if (GetTempFileNameA(tempDir, "run", 0, tempPath) == 0) {
+        return false;
+    }
+
+    hFile = CreateFileA(tempPath, GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+        FILE_ATTRIBUTE_TEMPORARY | FILE_FLAG_DELETE_ON_CLOSE | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    return hFile != INVALID_HANDLE_VALUE;
+}
+
+bool RunFile::append(const void* data, size_t size) {
+    const char* cursor = static_cast<const char*>(data);
+    while (size > 0) {
+        DWORD toWrite = static_cast<DWORD>(std::min<size_t>(size, 64 * 1024 * 1024));
+        DWORD written = 0;
+        if (!WriteFile(hFile, cursor, toWrite, &written, NULL) || written == 0) {
+            return false;
+        }
+        cursor += written;
+        size -= written;
+        bytesWritten += written;
+    }
+    return true;
+}
+
+bool RunFile::rewind() {
+    LARGE_INTEGER zero;
+    zero.QuadPart = 0;
+    return SetFilePointerEx(hFile, zero, NULL, FILE_BEGIN) != 0;
+}
+
+bool RunFile::read(void* data, size_t size) {
+    char* cursor = static_cast<char*>(data);
+    while (size > 0) {
+        DWORD toRead = static_cast<DWORD>(std::min<size_t>(size, 64 * 1024 * 1024));
+        DWORD bytesRead = 0;
+        if (!ReadFile(hFile, cursor, toRead, &bytesRead, NULL) || bytesRead == 0) {
+            return false;
+        }
+        cursor += bytesRead;
+        size -= bytesRead;
+    }
+    return true;
+}
+
+// Sorts a stream of any length on a fixed memory budget: incoming records
+// are collected into runs of runRecords, each run is sorted and spilled,
+// and finish() merges at most fanIn runs at a time until one pass can
+// feed the output directly.
+template <typename T>
+class ExternalSorter {
+public:
+    ExternalSorter(size_t runRecords, size_t fanIn, const std::string& tempDirectory = "");
+
+    bool add(const T* records, size_t count);
+
+    // emit(const T* records, size_t count) receives the sorted output in
+    // chunks of at most chunkRecords and returns false to abort.
+    template <typename Emit>
+    bool finish(size_t chunkRecords, Emit&& emit);
+
+    size_t spilledRuns() const { return runs.size(); }
+    uint64_t spilledBytes() const;
+
+private:
+    bool spillRun();
+
+    template <typename Emit>
+    bool mergeRuns(std::vector<std::unique_ptr<RunFile>>& sources, size_t chunkRecords, Emit&& emit);
+
+    size_t runRecords;
+    size_t fanIn;
+    std::string tempDirectory;
+    std::vector<T> runBuffer;
+    std::vector<std::unique_ptr<RunFile>> runs;
+};
+
+template <typename T>
+ExternalSorter<T>::ExternalSorter(size_t runRecords, size_t fanIn, const std::string& tempDirectory)
+    : runRecords(std::max<size_t>(runRecords, 1)), fanIn(std::max<size_t>(fanIn, 2)), tempDirectory(tempDirectory) {
+    runBuffer.reserve(this->runRecords);
+}
+
+template <typename T>
+bool ExternalSorter<T>::add(const T* records, size_t count) {
+    while (count > 0) {
+        size_t take = std::min(count, runRecords - runBuffer.size());
+        runBuffer.insert(runBuffer.end(), records, records + take);
+        records += take;
+        count -= take;
+        if (runBuffer.size() == runRecords && !spillRun()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename T>
+bool ExternalSorter<T>::spillRun() {
+    SortKeys(runBuffer.data(), runBuffer.size());
+
+    auto run = std::make_unique<RunFile>();
+    if (!run->create(tempDirectory) || !run->append(runBuffer.data(), runBuffer.size() * sizeof(T))) {
+        std::cerr << "Failed to spill a sorted run to disk." << std::endl;
+        return false;
+    }
+    runs.push_back(std::move(run));
+    runBuffer.clear();
+    return true;
+}
+
+template <typename T>
+uint64_t ExternalSorter<T>::spilledBytes() const {
+    uint64_t total = 0;
+    for (const auto& run : runs) {
+        total += run->size();
+    }
+    return total;
+}
+
+template <typename T>
+template <typename Emit>
+bool ExternalSorter<T>::finish(size_t chunkRecords, Emit&& emit) {
+    // Everything fit into one run: no disk round trip.
+    if (runs.empty()) {
+        SortKeys(runBuffer.data(), runBuffer.size());
+        for (size_t offset = 0; offset < runBuffer.size(); offset += chunkRecords) {
+            if (!emit(runBuffer.data() + offset, std::min(chunkRecords, runBuffer.size() - offset))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (!runBuffer.empty() && !spillRun()) {
+        return false;
+    }
+    std::vector<T>().swap(runBuffer);
+
+    // Intermediate passes: merge groups of fanIn runs into longer runs.
+    while (runs.size() > fanIn) {
+        std::vector<std::unique_ptr<RunFile>> merged;
+        for (size_t first = 0; first < runs.size(); first += fanIn) {
+            std::vector<std::unique_ptr<RunFile>> group;
+            for (size_t i = first; i < std::min(first + fanIn, runs.size()); ++i) {
+                group.push_back(std::move(runs[i]));
+            }
+
+            auto output = std::make_unique<RunFile>();
+            if (!output->create(tempDirectory)) {
+                std::cerr << "Failed to create a merge output run." << std::endl;
+                return false;
+            }
+            RunFile* target = output.get();
+            if (!mergeRuns(group, chunkRecords, [target](const T* records, size_t count) {
+                    return target->append(records, count * sizeof(T));
+                })) {
+                return false;
+            }
+            merged.push_back(std::move(output));
+        }
+        runs = std::move(merged);
+    }
+
+    return mergeRuns(runs, chunkRecords, emit);
+}
+
+template <typename T>
+template <typename Emit>
+bool ExternalSorter<T>::mergeRuns(std::vector<std::unique_ptr<RunFile>>& sources, size_t chunkRecords, Emit&& emit) {
+    struct RunCursor {
+        RunFile* run;
+        uint64_t remaining;
+        std::vector<T> buffer;
+        size_t position;
+    };
+
+    // The merge keeps one input buffer per run plus one output chunk, so the
+    // working set stays close to a single run regardless of fan-in.
+    const size_t bufferRecords = std::max<size_t>(runRecords / (sources.size() + 1), MIN_MERGE_BUFFER_RECORDS);
+
+    std::vector<RunCursor> cursors(sources.size());
+    LoserTree<T> tree(sources.size());
+
+    bool readFailed = false;
+    auto refill = [bufferRecords, &readFailed](RunCursor& cursor) -> const T* {
+        if (cursor.remaining == 0) return nullptr;
+        size_t count = static_cast<size_t>(std::min<uint64_t>(cursor.remaining, bufferRecords));
+        cursor.buffer.resize(count);
+        if (!cursor.run->read(cursor.buffer.data(), count * sizeof(T))) {
+            readFailed = true;
+            return nullptr;
+        }
+        cursor.remaining -= count;
+        cursor.position = 0;
+        return cursor.buffer.data();
+    };
+
+    for (size_t i = 0; i < sources.size(); ++i) {
+        cursors[i].run = sources[i].get();
+        cursors[i].remaining = sources[i]->size() / sizeof(T);
+        cursors[i].position = 0;
+        if (!cursors[i].run->rewind()) {
+            std::cerr << "Failed to rewind a sorted run." << std::endl;
+            return false;
+        }
+        tree.setHead(i, refill(cursors[i]));
+    }
+    // A run that cannot be read back stops the merge before anything more
+    // goes downstream; the records emitted so far are still in order, but
+    // the stream would be missing the rest of that run.
+    if (readFailed) {
+        std::cerr << "Failed to read back a sorted run." << std::endl;
+        return false;
+    }
+    tree.build();
+
+    std::vector<T> output;
+    output.reserve(chunkRecords);
+    while (!tree.empty()) {
+        output.push_back(tree.top());
+
+        RunCursor& cursor = cursors[tree.winner()];
+        const T* next = nullptr;
+        if (++cursor.position < cursor.buffer.size()) {
+            next = &cursor.buffer[cursor.position];
+        } else {
+            next = refill(cursor);
+            if (readFailed) {
+                std::cerr << "Failed to read back a sorted run." << std::endl;
+                return false;
+            }
+        }
+        tree.replaceWinner(next);
+
+        if (output.size() == chunkRecords) {
+            if (!emit(output.data(), output.size())) return false;
+            output.clear();
+        }
+    }
+
+    if (!output.empty() && !emit(output.data(), output.size())) {
+        return false;
+    }
+
+    sources.clear();
+    return true;
+}
+
+#endif // EXTERNAL_SORT_HPP
@@ -1,13 +1,179 @@
 #include <windows.h>
+#include <psapi.h>
+#include <atomic>
 #include <iostream>
+#include <fstream>
+#include <memory>
 #include <vector>
 #include <algorithm>
 #include <thread>
 #include <chrono>
 #include <string>
+#include <random>
+#include "asyncBlockReader.hpp"
+#include "datasetFormat.hpp"
+#include "incrementalSort.hpp"
+#include "radixSort.hpp"
 
-const char* filePath = "data.txt";
-const size_t dataSize = 1000000;
+#pragma comment(lib, "psapi.lib")
+
+#define MIN_RECORDS_PER_SORT_THREAD (64 * 1024)
+#define DEFAULT_FLUSH_RANGE_BYTES (8 * 1024 * 1024)
+#define DEFAULT_READ_AHEAD_BYTES (32 * 1024 * 1024)
+
+// The mmap variants are the Windows counterparts of the usual Linux knobs:
+// PrefetchVirtualMemory for MAP_POPULATE (synchronous) and
+// MADV_WILLNEED (on a helper thread, overlapping the consumer), and a
+// pagefile-backed SEC_LARGE_PAGES section for MAP_HUGETLB, since
+// file-backed sections cannot use large pages. Mapped views have no
+// MADV_SEQUENTIAL (FILE_FLAG_SEQUENTIAL_SCAN only steers read-ahead for
+// cached ReadFile calls), so mmap-sequential does the read-ahead itself:
+// PrefetchVirtualMemory over a window kept ahead of a front-to-back pass.
+//
+// The read-write modes sort a scratch copy of the file in place and differ
+// in how they persist it: FlushViewOfFile + FlushFileBuffers for
+// msync(MS_SYNC) plus fsync, FlushViewOfFile alone for MS_ASYNC (the pages
+// are handed to the device but neither its cache nor the metadata is
+// flushed), FlushViewOfFile per range for sync_file_range, and no flush
+// while mapped: the view is unmapped with its pages still dirty, and the
+// writeback the lazy writer still owes is forced and timed afterwards.
+enum class ReadMode {
+    Buffered,
+    MemoryMapped,
+    MappedPrefetch,
+    MappedWillNeed,
+    MappedSequential,
+    MappedParallelPrefault,
+    LargePages,
+    AsyncIoRing,
+    AsyncThreadPool,
+    Unbuffered,
+    MappedWriteSync,
+    MappedWriteAsync,
+    MappedWriteRanges,
+    MappedWriteLazy,
+};
+
+const char* readModeName(ReadMode mode) {
+    switch (mode) {
+    case ReadMode::Buffered: return "buffered";
+    case ReadMode::MemoryMapped: return "mmap";
+    case ReadMode::MappedPrefetch: return "mmap-prefetch";
+    case ReadMode::MappedWillNeed: return "mmap-willneed";
+    case ReadMode::MappedSequential: return "mmap-sequential";
+    case ReadMode::MappedParallelPrefault: return "mmap-parallel-prefault";
+    case ReadMode::LargePages: return "large-pages";
+    case ReadMode::AsyncIoRing: return "async-ioring";
+    case ReadMode::AsyncThreadPool: return "async-threadpool";
+    case ReadMode::Unbuffered: return "unbuffered";
+    case ReadMode::MappedWriteSync: return "mmap-rw-sync";
+    case ReadMode::MappedWriteAsync: return "mmap-rw-async";
+    case ReadMode::MappedWriteRanges: return "mmap-rw-ranges";
+    case ReadMode::MappedWriteLazy: return "mmap-rw-lazy";
+    }
+    return "buffered";
+}
+
+const ReadMode allReadModes[] = { ReadMode::Buffered, ReadMode::MemoryMapped, ReadMode::MappedPrefetch, ReadMode::MappedWillNeed,
+                                  ReadMode::MappedSequential, ReadMode::MappedParallelPrefault, ReadMode::LargePages,
+                                  ReadMode::AsyncIoRing, ReadMode::AsyncThreadPool, ReadMode::Unbuffered,
+                                  ReadMode::MappedWriteSync, ReadMode::MappedWriteAsync, ReadMode::MappedWriteRanges,
+                                  ReadMode::MappedWriteLazy };
+
+// Cold runs start with the dataset evicted from the system file cache, warm
+// runs with all of it cached.
+enum class CacheState {
+    Cold,
+    Warm,
+};
+
+const char* cacheStateName(CacheState state) {
+    return state == CacheState::Cold ? "cold" : "warm";
+}
+
+struct BenchmarkConfig {
+    std::string filePath = "data.bin";   // A dataset written by datasetGenerator.
+    size_t recordCount = 0;              // 0 uses the whole dataset.
+    unsigned warmupRuns = 1;
+    unsigned repetitions = 10;
+    std::vector<ReadMode> modes = { ReadMode::Buffered, ReadMode::MemoryMapped };
+    std::vector<CacheState> cacheStates = { CacheState::Cold, CacheState::Warm };
+    uint64_t orderSeed = 1;         // Seeds the shuffled run order of each repetition.
+    unsigned prefaultThreads = 0;   // 0 uses every core.
+    unsigned sortThreads = 0;       // 0 uses every core.
+    unsigned ioQueueDepth = DEFAULT_READ_QUEUE_DEPTH;
+    size_t ioBlockBytes = DEFAULT_READ_BLOCK_BYTES;
+    unsigned unbufferedBuffers = DEFAULT_UNBUFFERED_BUFFERS;
+    size_t flushRangeBytes = DEFAULT_FLUSH_RANGE_BYTES;
+    size_t readAheadBytes = DEFAULT_READ_AHEAD_BYTES;   // Window of mmap-sequential.
+    bool verifyChecksums = false;
+};
+
+// OS counters of the benchmark process over one run. Page faults count
+// soft and hard faults together; hard faults are the ones that had to read
+// from storage. Reads through a mapped view are paging I/O and do not show
+// up in readBytes, only in hardFaults. Windows offers neither PMU counters
+// (instructions, cache and TLB misses) nor a voluntary/involuntary context
+// switch split to user mode, so cycles and user/kernel time stand in.
+struct RunCounters {
+    double pageFaults = 0.0;
+    double hardFaults = 0.0;
+    double readOperations = 0.0;
+    double readBytes = 0.0;
+    double writeBytes = 0.0;
+    double cycles = 0.0;
+    double userSeconds = 0.0;
+    double kernelSeconds = 0.0;
+};
+
+// One measured repetition, split into getting the data into memory, sorting
+// it, making the result durable (read-write modes only), and releasing
+// everything again.
+struct PhaseTimes {
+    double io = 0.0;
+    double compute = 0.0;
+    double persist = 0.0;
+    double teardown = 0.0;
+    double pageCacheGrowth = 0.0;   // Bytes the system file cache grew by over the run.
+    RunCounters counters;
+
+    double total() const { return io + compute + persist + teardown; }
+};
+
+struct SampleStats {
+    double min = 0.0;
+    double median = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+};
+
+struct ModeResult {
+    ReadMode mode;
+    CacheState cache = CacheState::Warm;
+    bool success = false;
+    std::vector<PhaseTimes> samples;
+    SampleStats io;
+    SampleStats compute;
+    SampleStats persist;
+    SampleStats teardown;
+    SampleStats total;
+    SampleStats pageCacheGrowth;
+    RunCounters counters;       // Medians over the repetitions.
+};
+
+struct BenchmarkReport {
+    BenchmarkConfig config;
+    ElementType elementType = ElementType::Int32;
+    size_t elementBytes = sizeof(int32_t);
+    std::vector<ModeResult> modes;
+
+    // Records and wide records sort at very different rates per element, so
+    // modes are compared in bytes per second.
+    double mibPerSecond(double seconds) const {
+        return seconds > 0 ? static_cast<double>(config.recordCount * elementBytes) / seconds / (1024 * 1024) : 0.0;
+    }
+};
 
 std::wstring convertToWideString(const char* str) {
     size_t len = strlen(str) + 1;
@@ -16,50 +182,794 @@ std::wstring convertToWideString(const char* str) {
     return wstr;
 }
 
-void processData(int* data, size_t size) {
-    std::sort(data, data + size);
-}
-
-std::pair<double, double> benchmark() {
-    int* data = new int[dataSize];
-    auto start = std::chrono::high_resolution_clock::now();
-    FILE* file = fopen(filePath, "rb");
-    if (file) {
-        fread(data, sizeof(int), dataSize, file);
-        fclose(file);
-    }
-    
-    std::thread t1(processData, data, dataSize);
-    std::thread t2(processData, data, dataSize);
-    t1.join();
-    t2.join();
-    
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration = end - start;
-    std::cout << "Traditional File Reading took " << duration.count() << " seconds.\n";
-    std::pair<double, double> result;
-    result.first = duration.count();
-
-    start = std::chrono::high_resolution_clock::now();
-    std::wstring wFilePath = convertToWideString(filePath);
-    HANDLE hFile = CreateFileW(wFilePath.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
-    HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
-    if (hMapping) {
-        int* mappedData = (int*)MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
-        if (mappedData) {
-            std::thread t1(processData, mappedData, dataSize);
-            std::thread t2(processData, mappedData, dataSize);
-            t1.join();
-            t2.join();
-            UnmapViewOfFile(mappedData);
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentiles over the repetitions.
+SampleStats computeStats(std::vector<double> values) {
+    SampleStats stats;
+    if (values.empty()) return stats;
+
+    std::sort(values.begin(), values.end());
+    auto rank = [&values](double fraction) {
+        size_t index = static_cast<size_t>(fraction * static_cast<double>(values.size()) + 0.999999);
+        return values[std::clamp<size_t>(index, 1, values.size()) - 1];
+    };
+    stats.min = values.front();
+    stats.median = rank(0.50);
+    stats.p95 = rank(0.95);
+    stats.p99 = rank(0.99);
+    for (double value : values) stats.mean += value;
+    stats.mean /= static_cast<double>(values.size());
+    return stats;
+}
+
+// Sorts threadCount contiguous partitions concurrently, then merges them
+// pairwise; the merges of each round run in parallel as well, ping-ponging
+// between the data and a scratch buffer.
+template <typename T>
+void processData(T* data, size_t size, unsigned threadCount = 0) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::clamp<size_t>(size / MIN_RECORDS_PER_SORT_THREAD, 1, threadCount));
+    if (threadCount == 1) {
+        SortKeys(data, size, 1);
+        return;
+    }
+
+    std::vector<size_t> bounds;
+    for (unsigned i = 0; i <= threadCount; ++i) {
+        bounds.push_back(size * i / threadCount);
+    }
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < threadCount; ++i) {
+        threads.emplace_back([data, &bounds, i] { SortKeys(data + bounds[i], bounds[i + 1] - bounds[i], 1); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::unique_ptr<T[]> scratch(new T[size]);
+    T* from = data;
+    T* to = scratch.get();
+    while (bounds.size() > 2) {
+        std::vector<size_t> merged = { 0 };
+        threads.clear();
+        for (size_t i = 0; i + 1 < bounds.size(); i += 2) {
+            const size_t low = bounds[i];
+            const size_t middle = bounds[i + 1];
+            const size_t high = i + 2 < bounds.size() ? bounds[i + 2] : middle;
+            threads.emplace_back([from, to, low, middle, high] { std::merge(from + low, from + middle, from + middle, from + high, to + low); });
+            merged.push_back(high);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        std::swap(from, to);
+        bounds = merged;
+    }
+    if (from != data) {
+        std::copy(from, from + size, data);
+    }
+}
+
+// Validates the dataset once, before any run; the runs then only read the
+// payload. A recordCount of 0 is resolved to the dataset's count.
+bool openDataset(BenchmarkConfig& config, DatasetHeader& dataset) {
+    HANDLE hFile = CreateFileA(config.filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << config.filePath << ".\n";
+        return false;
+    }
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    bool ok = ReadDatasetHeader(hFile, config.filePath, dataset);
+    if (ok && config.recordCount > dataset.count) {
+        std::cerr << config.filePath << " holds only " << dataset.count << " records.\n";
+        ok = false;
+    }
+    // Views can only start on an allocation-granularity boundary.
+    if (ok && dataset.payloadOffset % info.dwAllocationGranularity != 0) {
+        std::cerr << "The payload of " << config.filePath << " cannot be mapped on its own.\n";
+        ok = false;
+    }
+    ok = ok && (!config.verifyChecksums || VerifyDatasetChecksums(hFile, config.filePath, dataset));
+    CloseHandle(hFile);
+    if (ok && config.recordCount == 0) {
+        config.recordCount = static_cast<size_t>(dataset.count);
+    }
+    return ok;
+}
+
+// Size of the system file cache, to see how much of it a mode leaves behind.
+double pageCacheBytes() {
+    PERFORMANCE_INFORMATION info;
+    if (!GetPerformanceInfo(&info, sizeof(info))) return 0.0;
+    return static_cast<double>(info.SystemCache) * static_cast<double>(info.PageSize);
+}
+
+// HardFaultCount is only published in the SYSTEM_PROCESS_INFORMATION
+// records of NtQuerySystemInformation; these are their leading fields.
+struct ProcessInformationPrefix {
+    ULONG nextEntryOffset;
+    ULONG numberOfThreads;
+    LARGE_INTEGER workingSetPrivateSize;
+    ULONG hardFaultCount;
+    ULONG numberOfThreadsHighWatermark;
+    ULONGLONG cycleTime;
+    LARGE_INTEGER createTime;
+    LARGE_INTEGER userTime;
+    LARGE_INTEGER kernelTime;
+    struct { USHORT length; USHORT maximumLength; PWSTR buffer; } imageName;
+    LONG basePriority;
+    HANDLE uniqueProcessId;
+};
+
+#define SYSTEM_PROCESS_INFORMATION_CLASS 5
+#define STATUS_INFO_LENGTH_MISMATCH_CODE static_cast<NTSTATUS>(0xC0000004L)
+
+double hardFaultCount() {
+    using QuerySystemInformation = NTSTATUS (WINAPI*)(ULONG, PVOID, ULONG, PULONG);
+    static const auto query = reinterpret_cast<QuerySystemInformation>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtQuerySystemInformation"));
+    static std::vector<char> buffer(1 << 20);
+    if (!query) return 0.0;
+
+    ULONG needed = 0;
+    NTSTATUS status;
+    while ((status = query(SYSTEM_PROCESS_INFORMATION_CLASS, buffer.data(), static_cast<ULONG>(buffer.size()), &needed)) == STATUS_INFO_LENGTH_MISMATCH_CODE) {
+        buffer.resize(std::max<size_t>(needed, buffer.size() * 2));
+    }
+    if (status < 0) return 0.0;
+
+    const HANDLE self = reinterpret_cast<HANDLE>(static_cast<ULONG_PTR>(GetCurrentProcessId()));
+    for (size_t offset = 0;;) {
+        const auto* process = reinterpret_cast<const ProcessInformationPrefix*>(buffer.data() + offset);
+        if (process->uniqueProcessId == self) return static_cast<double>(process->hardFaultCount);
+        if (process->nextEntryOffset == 0) return 0.0;
+        offset += process->nextEntryOffset;
+    }
+}
+
+double fileTimeSeconds(const FILETIME& time) {
+    ULARGE_INTEGER value;
+    value.LowPart = time.dwLowDateTime;
+    value.HighPart = time.dwHighDateTime;
+    return static_cast<double>(value.QuadPart) / 1e7;
+}
+
+RunCounters captureCounters() {
+    RunCounters counters;
+    const HANDLE process = GetCurrentProcess();
+    PROCESS_MEMORY_COUNTERS memory;
+    if (GetProcessMemoryInfo(process, &memory, sizeof(memory))) {
+        counters.pageFaults = memory.PageFaultCount;
+    }
+    counters.hardFaults = hardFaultCount();
+    IO_COUNTERS io;
+    if (GetProcessIoCounters(process, &io)) {
+        counters.readOperations = static_cast<double>(io.ReadOperationCount);
+        counters.readBytes = static_cast<double>(io.ReadTransferCount);
+        counters.writeBytes = static_cast<double>(io.WriteTransferCount);
+    }
+    ULONG64 cycles = 0;
+    if (QueryProcessCycleTime(process, &cycles)) {
+        counters.cycles = static_cast<double>(cycles);
+    }
+    FILETIME creationTime, exitTime, kernelTime, userTime;
+    if (GetProcessTimes(process, &creationTime, &exitTime, &kernelTime, &userTime)) {
+        counters.userSeconds = fileTimeSeconds(userTime);
+        counters.kernelSeconds = fileTimeSeconds(kernelTime);
+    }
+    return counters;
+}
+
+RunCounters counterDelta(const RunCounters& before, const RunCounters& after) {
+    return { after.pageFaults - before.pageFaults, after.hardFaults - before.hardFaults,
+             after.readOperations - before.readOperations, after.readBytes - before.readBytes,
+             after.writeBytes - before.writeBytes, after.cycles - before.cycles,
+             after.userSeconds - before.userSeconds, after.kernelSeconds - before.kernelSeconds };
+}
+
+// Counter and page-cache snapshots bracket only the timed phases of a run,
+// so setup a mode does before its clock starts (the scratch copy of the
+// read-write modes, its cache preparation) is not charged to it.
+struct RunMeasurement {
+    double cacheBefore = pageCacheBytes();
+    RunCounters countersBefore = captureCounters();
+
+    void finish(PhaseTimes& times) const {
+        times.counters = counterDelta(countersBefore, captureCounters());
+        times.pageCacheGrowth = pageCacheBytes() - cacheBefore;
+    }
+};
+
+template <typename T>
+bool runBuffered(const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    const RunMeasurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<T[]> data(new T[config.recordCount]);
+    FILE* file = fopen(config.filePath.c_str(), "rb");
+    if (!file) {
+        std::cerr << "Failed to open " << config.filePath << ".\n";
+        return false;
+    }
+    size_t read = 0;
+    if (_fseeki64(file, static_cast<int64_t>(dataset.payloadOffset), SEEK_SET) == 0) {
+        read = fread(data.get(), sizeof(T), config.recordCount, file);
+    }
+    fclose(file);
+    if (read != config.recordCount) {
+        std::cerr << "Failed to read " << config.filePath << ".\n";
+        return false;
+    }
+    times.io = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    processData(data.get(), config.recordCount, config.sortThreads);
+    times.compute = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    data.reset();
+    times.teardown = secondsSince(start);
+    measurement.finish(times);
+    return true;
+}
+
+// Touches one byte per page so the view is faulted in by several threads
+// at once instead of by the consumer, one fault at a time.
+void prefaultParallel(const char* view, size_t bytes, unsigned threadCount) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t pageBytes = info.dwPageSize;
+    const size_t pages = (bytes + pageBytes - 1) / pageBytes;
+    threadCount = std::max<unsigned>(1, std::min<size_t>(threadCount ? threadCount : std::thread::hardware_concurrency(), pages));
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        threads.emplace_back([view, bytes, pageBytes, pages, t, threadCount] {
+            volatile char sink = 0;
+            for (size_t page = pages * t / threadCount; page < pages * (t + 1) / threadCount; ++page) {
+                sink = view[std::min(page * pageBytes, bytes - 1)];
+            }
+            (void)sink;
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+// Touches the view front to back, one byte per page, while a helper thread
+// prefetches the window after the one being touched, so the reads stay
+// ahead of the pass without pulling in the whole view at once.
+void prefaultSequential(const char* view, size_t bytes, size_t windowBytes) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    const size_t pageBytes = info.dwPageSize;
+    windowBytes = std::max(windowBytes / pageBytes, size_t(1)) * pageBytes;
+
+    std::atomic<size_t> touched{ 0 };
+    std::thread readAhead([view, bytes, windowBytes, &touched] {
+        for (size_t offset = 0; offset < bytes; offset += windowBytes) {
+            while (offset > touched.load(std::memory_order_relaxed) + windowBytes) {
+                std::this_thread::yield();
+            }
+            WIN32_MEMORY_RANGE_ENTRY range = { const_cast<char*>(view) + offset, std::min(windowBytes, bytes - offset) };
+            PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
         }
+    });
+
+    volatile char sink = 0;
+    for (size_t offset = 0; offset < bytes; offset += pageBytes) {
+        sink = view[offset];
+        touched.store(offset, std::memory_order_relaxed);
+    }
+    (void)sink;
+    readAhead.join();
+}
+
+// The records are sorted in place in a copy-on-write view: the file stays
+// untouched and every page the sort writes becomes a private copy. Unless
+// the mode prefetches, the page faults (and with them the actual I/O) land
+// in the compute phase.
+template <typename T>
+bool runMemoryMapped(ReadMode mode, const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    const RunMeasurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    const size_t bytes = config.recordCount * sizeof(T);
+    std::wstring wFilePath = convertToWideString(config.filePath.c_str());
+    HANDLE hFile = CreateFileW(wFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << config.filePath << ".\n";
+        return false;
+    }
+    HANDLE hMapping = CreateFileMapping(hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+    T* mappedData = hMapping ? (T*)MapViewOfFile(hMapping, FILE_MAP_COPY,
+        static_cast<DWORD>(dataset.payloadOffset >> 32), static_cast<DWORD>(dataset.payloadOffset), bytes) : nullptr;
+    if (!mappedData) {
+        std::cerr << "Failed to map " << config.filePath << " (" << GetLastError() << ").\n";
+        if (hMapping) CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    WIN32_MEMORY_RANGE_ENTRY range = { mappedData, bytes };
+    std::thread willNeed;
+    if (mode == ReadMode::MappedPrefetch) {
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    } else if (mode == ReadMode::MappedWillNeed) {
+        willNeed = std::thread([&range] { PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0); });
+    } else if (mode == ReadMode::MappedSequential) {
+        prefaultSequential(reinterpret_cast<const char*>(mappedData), bytes, config.readAheadBytes);
+    } else if (mode == ReadMode::MappedParallelPrefault) {
+        prefaultParallel(reinterpret_cast<const char*>(mappedData), bytes, config.prefaultThreads);
+    }
+    times.io = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    processData(mappedData, config.recordCount, config.sortThreads);
+    if (willNeed.joinable()) {
+        willNeed.join();
+    }
+    times.compute = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    UnmapViewOfFile(mappedData);
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+    times.teardown = secondsSince(start);
+    measurement.finish(times);
+    return true;
+}
+
+// Opening a file without buffering makes the cache manager write back and
+// drop every cached page of it, provided no other handle or view keeps the
+// file open. This is the Windows counterpart of POSIX_FADV_DONTNEED.
+bool evictFromCache(const std::string& path) {
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to evict " << path << " from the file cache.\n";
+        return false;
+    }
+    CloseHandle(hFile);
+    return true;
+}
+
+// Reads the whole file through the cache once.
+bool prewarmCache(const std::string& path) {
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to prewarm " << path << ".\n";
+        return false;
+    }
+    std::unique_ptr<char[]> buffer(new char[DEFAULT_READ_BLOCK_BYTES]);
+    DWORD read = 0;
+    while (ReadFile(hFile, buffer.get(), DEFAULT_READ_BLOCK_BYTES, &read, NULL) && read > 0) {}
+    CloseHandle(hFile);
+    return true;
+}
+
+bool prepareCache(CacheState state, const std::string& path) {
+    return state == CacheState::Cold ? evictFromCache(path) : prewarmCache(path);
+}
+
+// Sorts a scratch copy of the dataset in place through a read-write view
+// and persists it as the mode asks, the way a sorted shard is rewritten
+// without a second copy. Copying the dataset, and bringing the copy into
+// the requested cache state, is not timed. The persist
+// phase is the durability cost. The lazy mode unmaps first and then times a
+// FlushFileBuffers of the file, i.e. whatever the lazy writer had not yet
+// written back; the scratch file is only deleted after that, since the
+// dirty pages of a deleted file are discarded rather than written.
+template <typename T>
+bool runMappedWriteback(ReadMode mode, CacheState cache, const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    const std::string scratchPath = config.filePath + ".scratch";
+    if (!CopyFileA(config.filePath.c_str(), scratchPath.c_str(), FALSE) || !prepareCache(cache, scratchPath)) {
+        std::cerr << "Failed to copy " << config.filePath << " to " << scratchPath << ".\n";
+        DeleteFileA(scratchPath.c_str());
+        return false;
+    }
+
+    const RunMeasurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    const size_t bytes = config.recordCount * sizeof(T);
+    HANDLE hFile = CreateFileA(scratchPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    HANDLE hMapping = hFile != INVALID_HANDLE_VALUE ? CreateFileMapping(hFile, NULL, PAGE_READWRITE, 0, 0, NULL) : NULL;
+    T* mappedData = hMapping ? (T*)MapViewOfFile(hMapping, FILE_MAP_WRITE,
+        static_cast<DWORD>(dataset.payloadOffset >> 32), static_cast<DWORD>(dataset.payloadOffset), bytes) : nullptr;
+    if (!mappedData) {
+        std::cerr << "Failed to map " << scratchPath << " for writing (" << GetLastError() << ").\n";
+        if (hMapping) CloseHandle(hMapping);
+        if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+        DeleteFileA(scratchPath.c_str());
+        return false;
+    }
+    times.io = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    processData(mappedData, config.recordCount, config.sortThreads);
+    times.compute = secondsSince(start);
+
+    if (mode == ReadMode::MappedWriteLazy) {
+        start = std::chrono::steady_clock::now();
+        UnmapViewOfFile(mappedData);
         CloseHandle(hMapping);
+        times.teardown = secondsSince(start);
+
+        start = std::chrono::steady_clock::now();
+        const bool ok = FlushFileBuffers(hFile);
+        times.persist = secondsSince(start);
+        measurement.finish(times);
+        if (!ok) {
+            std::cerr << "Failed to write back " << scratchPath << " (" << GetLastError() << ").\n";
+        }
+        CloseHandle(hFile);
+        DeleteFileA(scratchPath.c_str());
+        return ok;
     }
+
+    start = std::chrono::steady_clock::now();
+    bool ok = true;
+    if (mode == ReadMode::MappedWriteSync) {
+        ok = FlushViewOfFile(mappedData, bytes) && FlushFileBuffers(hFile);
+    } else if (mode == ReadMode::MappedWriteAsync) {
+        ok = FlushViewOfFile(mappedData, bytes);
+    } else if (mode == ReadMode::MappedWriteRanges) {
+        const size_t rangeBytes = std::max<size_t>(config.flushRangeBytes, 4096);
+        for (size_t offset = 0; ok && offset < bytes; offset += rangeBytes) {
+            ok = FlushViewOfFile(reinterpret_cast<char*>(mappedData) + offset, std::min(rangeBytes, bytes - offset));
+        }
+    }
+    times.persist = secondsSince(start);
+    if (!ok) {
+        std::cerr << "Failed to write back " << scratchPath << " (" << GetLastError() << ").\n";
+    }
+
+    start = std::chrono::steady_clock::now();
+    UnmapViewOfFile(mappedData);
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+    times.teardown = secondsSince(start);
+    measurement.finish(times);
+    DeleteFileA(scratchPath.c_str());
+    return ok;
+}
+
+// Large pages have to be locked in memory, which needs SeLockMemoryPrivilege
+// granted to the account and enabled in the process token.
+bool enableLockMemoryPrivilege() {
+    static const bool enabled = [] {
+        HANDLE hToken;
+        if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &hToken)) {
+            return false;
+        }
+        TOKEN_PRIVILEGES privileges = {};
+        privileges.PrivilegeCount = 1;
+        privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+        bool ok = LookupPrivilegeValueA(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid) &&
+                  AdjustTokenPrivileges(hToken, FALSE, &privileges, 0, NULL, NULL) &&
+                  GetLastError() != ERROR_NOT_ALL_ASSIGNED;
+        CloseHandle(hToken);
+        return ok;
+    }();
+    return enabled;
+}
+
+// Reads the file into a pagefile-backed large-page section and sorts it
+// there, so the sort runs with a fraction of the TLB misses.
+template <typename T>
+bool runLargePages(const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    const SIZE_T largePage = GetLargePageMinimum();
+    if (largePage == 0 || !enableLockMemoryPrivilege()) {
+        std::cerr << "Large pages are unavailable (SeLockMemoryPrivilege is required).\n";
+        return false;
+    }
+
+    const RunMeasurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    const size_t bytes = config.recordCount * sizeof(T);
+    const uint64_t sectionBytes = (bytes + largePage - 1) / largePage * largePage;
+    HANDLE hFile = CreateFileA(config.filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open " << config.filePath << ".\n";
+        return false;
+    }
+    HANDLE hSection = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE | SEC_COMMIT | SEC_LARGE_PAGES,
+        static_cast<DWORD>(sectionBytes >> 32), static_cast<DWORD>(sectionBytes), NULL);
+    T* data = hSection ? (T*)MapViewOfFile(hSection, FILE_MAP_WRITE | FILE_MAP_LARGE_PAGES, 0, 0, static_cast<SIZE_T>(sectionBytes)) : nullptr;
+    if (!data) {
+        std::cerr << "Failed to create a large-page section (" << GetLastError() << ").\n";
+        if (hSection) CloseHandle(hSection);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    if (!ReadAt(hFile, dataset.payloadOffset, data, bytes)) {
+        std::cerr << "Failed to read " << config.filePath << ".\n";
+        UnmapViewOfFile(data);
+        CloseHandle(hSection);
+        CloseHandle(hFile);
+        return false;
+    }
+    times.io = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    processData(data, config.recordCount, config.sortThreads);
+    times.compute = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    UnmapViewOfFile(data);
+    CloseHandle(hSection);
     CloseHandle(hFile);
-    end = std::chrono::high_resolution_clock::now();
-    duration = end - start;
-    std::cout << "Memory-Mapped File Reading took " << duration.count() << " seconds.\n";
-    result.second = duration.count();
+    times.teardown = secondsSince(start);
+    measurement.finish(times);
+    return true;
+}
 
-    return result;
-}
\ No newline at end of file
+// Blocks are sorted by worker threads as their reads complete, while later
+// reads are still in flight, so the I/O phase already includes most of the
+// sorting; the compute phase is the final merge of the sorted blocks.
+template <typename T>
+bool runAsyncRead(ReadMode mode, const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    const RunMeasurement measurement;
+    auto start = std::chrono::steady_clock::now();
+    const uint64_t bytes = config.recordCount * sizeof(T);
+    const size_t blockBytes = std::max<size_t>(config.ioBlockBytes / 4096 * 4096, 4096);
+    auto sorter = std::make_unique<IncrementalSorter<T>>(config.sortThreads);
+    BlockHandler onBlock = [&sorter](const char* data, size_t size, uint64_t) {
+        sorter->add(reinterpret_cast<const T*>(data), size / sizeof(T));
+        return true;
+    };
+
+    bool ok = false;
+    bool ioRingUnavailable = true;
+    if (mode == ReadMode::AsyncIoRing) {
+        ok = readBlocksIoRing(config.filePath, dataset.payloadOffset, bytes, blockBytes, config.ioQueueDepth, onBlock, ioRingUnavailable);
+        static bool reported = false;
+        if (ioRingUnavailable && !reported) {
+            std::cout << "IoRing is not available, falling back to the thread-pool reader.\n";
+            reported = true;
+        }
+    }
+    if (mode == ReadMode::Unbuffered) {
+        ok = readBlocksUnbuffered(config.filePath, dataset.payloadOffset, bytes, blockBytes, config.unbufferedBuffers, onBlock);
+    } else if (ioRingUnavailable) {
+        ok = readBlocksThreadPool(config.filePath, dataset.payloadOffset, bytes, blockBytes, config.ioQueueDepth, onBlock);
+    }
+    if (!ok) {
+        std::cerr << "Failed to read " << config.filePath << ".\n";
+        return false;
+    }
+    times.io = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::unique_ptr<T[]> data(new T[config.recordCount]);
+    size_t merged = 0;
+    const size_t recordCount = config.recordCount;
+    const bool finished = sorter->finish(blockBytes / sizeof(T), [&data, &merged, recordCount](const T* records, size_t count) {
+        if (count > recordCount - merged) return false;
+        std::copy(records, records + count, data.get() + merged);
+        merged += count;
+        return true;
+    });
+    if (!finished || merged != recordCount) {
+        std::cerr << "Failed to merge the sorted blocks of " << config.filePath << ".\n";
+        return false;
+    }
+    times.compute = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    sorter.reset();
+    data.reset();
+    times.teardown = secondsSince(start);
+    measurement.finish(times);
+    return true;
+}
+
+template <typename T>
+bool runModeAs(ReadMode mode, CacheState cache, const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    switch (mode) {
+    case ReadMode::Buffered: return runBuffered<T>(config, dataset, times);
+    case ReadMode::MemoryMapped:
+    case ReadMode::MappedPrefetch:
+    case ReadMode::MappedWillNeed:
+    case ReadMode::MappedSequential:
+    case ReadMode::MappedParallelPrefault: return runMemoryMapped<T>(mode, config, dataset, times);
+    case ReadMode::LargePages: return runLargePages<T>(config, dataset, times);
+    case ReadMode::AsyncIoRing:
+    case ReadMode::AsyncThreadPool:
+    case ReadMode::Unbuffered: return runAsyncRead<T>(mode, config, dataset, times);
+    case ReadMode::MappedWriteSync:
+    case ReadMode::MappedWriteAsync:
+    case ReadMode::MappedWriteRanges:
+    case ReadMode::MappedWriteLazy: return runMappedWriteback<T>(mode, cache, config, dataset, times);
+    }
+    return false;
+}
+
+// Every element type gets its own instantiation of the read modes, and with
+// it the sort kernel SortKeys() picks for that type.
+bool runMode(ReadMode mode, CacheState cache, const BenchmarkConfig& config, const DatasetHeader& dataset, PhaseTimes& times) {
+    return VisitElementType(static_cast<ElementType>(dataset.elementType), [&](auto type) {
+        return runModeAs<typename decltype(type)::type>(mode, cache, config, dataset, times);
+    });
+}
+
+// Runs every mode in every cache state for warmupRuns unrecorded and then
+// repetitions recorded iterations. Runs are interleaved per repetition so
+// that slow drift of the machine (thermal, background load) affects all of
+// them alike, and shuffled so that no mode always inherits the cache, the
+// dirty pages or the free memory left behind by the same predecessor. The
+// cache state is set up right before each run, outside the timed region.
+BenchmarkReport benchmark(const BenchmarkConfig& config = {}) {
+    BenchmarkReport report;
+    report.config = config;
+    DatasetHeader dataset;
+    const bool valid = openDataset(report.config, dataset);
+    if (valid) {
+        report.elementType = static_cast<ElementType>(dataset.elementType);
+        report.elementBytes = dataset.elementBytes;
+    }
+    for (ReadMode mode : config.modes) {
+        for (CacheState cache : config.cacheStates) {
+            ModeResult result;
+            result.mode = mode;
+            result.cache = cache;
+            result.success = valid;
+            report.modes.push_back(result);
+        }
+    }
+
+    std::mt19937_64 random(config.orderSeed);
+    std::vector<ModeResult*> order;
+    for (auto& result : report.modes) {
+        order.push_back(&result);
+    }
+    for (unsigned iteration = 0; iteration < config.warmupRuns + config.repetitions; ++iteration) {
+        std::shuffle(order.begin(), order.end(), random);
+        for (ModeResult* run : order) {
+            ModeResult& result = *run;
+            if (!result.success) continue;
+            PhaseTimes times;
+            result.success = prepareCache(result.cache, config.filePath);
+            if (!result.success) continue;
+            result.success = runMode(result.mode, result.cache, report.config, dataset, times);
+            if (result.success && iteration >= config.warmupRuns) {
+                result.samples.push_back(times);
+            }
+        }
+    }
+
+    for (auto& result : report.modes) {
+        std::vector<double> io, compute, persist, teardown, total, pageCache;
+        for (const auto& sample : result.samples) {
+            pageCache.push_back(sample.pageCacheGrowth);
+            io.push_back(sample.io);
+            compute.push_back(sample.compute);
+            persist.push_back(sample.persist);
+            teardown.push_back(sample.teardown);
+            total.push_back(sample.total());
+        }
+        result.io = computeStats(io);
+        result.compute = computeStats(compute);
+        result.persist = computeStats(persist);
+        result.teardown = computeStats(teardown);
+        result.total = computeStats(total);
+        result.pageCacheGrowth = computeStats(pageCache);
+        auto counterMedian = [&result](double RunCounters::*counter) {
+            std::vector<double> values;
+            for (const auto& sample : result.samples) values.push_back(sample.counters.*counter);
+            return computeStats(values).median;
+        };
+        for (double RunCounters::*counter : { &RunCounters::pageFaults, &RunCounters::hardFaults, &RunCounters::readOperations,
+                                              &RunCounters::readBytes, &RunCounters::writeBytes, &RunCounters::cycles,
+                                              &RunCounters::userSeconds, &RunCounters::kernelSeconds }) {
+            result.counters.*counter = counterMedian(counter);
+        }
+        std::cout << readModeName(result.mode) << " (" << cacheStateName(result.cache) << "): median " << result.total.median << " s ("
+                  << report.mibPerSecond(result.total.median) << " MiB/s " << ElementTypeName(report.elementType) << "; io "
+                  << result.io.median << " s, compute " << result.compute.median << " s, persist "
+                  << result.persist.median << " s), p99 "
+                  << result.total.p99 << " s over " << result.samples.size() << " runs, page cache +"
+                  << result.pageCacheGrowth.median / (1024 * 1024) << " MiB, " << result.counters.pageFaults << " faults ("
+                  << result.counters.hardFaults << " hard), " << result.counters.readBytes / (1024 * 1024) << " MiB read.\n";
+    }
+    return report;
+}
+
+struct SortScalingPoint {
+    unsigned threads = 0;
+    ReadMode mode;
+    CacheState cache;
+    double computeMedian = 0.0;
+    double totalMedian = 0.0;
+};
+
+// Reruns the benchmark with 1..maxThreads sort threads (all cores by
+// default) to get the scaling curve of the partitioned sort.
+std::vector<SortScalingPoint> sortScalingSweep(BenchmarkConfig config, unsigned maxThreads = 0) {
+    if (maxThreads == 0) {
+        maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    std::vector<SortScalingPoint> points;
+    for (unsigned threads = 1; threads <= maxThreads; ++threads) {
+        config.sortThreads = threads;
+        for (const auto& result : benchmark(config).modes) {
+            points.push_back({ threads, result.mode, result.cache, result.compute.median, result.total.median });
+        }
+    }
+    return points;
+}
+
+// One row per mode and phase.
+bool writeBenchmarkCsv(const BenchmarkReport& report, const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    file << "mode,cache,phase,element,records,samples,min_s,median_s,p95_s,p99_s,mean_s,median_mib_per_s,page_cache_growth_bytes,"
+            "page_faults,hard_faults,read_operations,read_bytes,write_bytes,cycles,user_s,kernel_s\n";
+    for (const auto& result : report.modes) {
+        const std::pair<const char*, const SampleStats*> phases[] = {
+            { "io", &result.io }, { "compute", &result.compute }, { "persist", &result.persist },
+            { "teardown", &result.teardown }, { "total", &result.total } };
+        for (const auto& [phase, stats] : phases) {
+            file << readModeName(result.mode) << ',' << cacheStateName(result.cache) << ',' << phase << ','
+                 << ElementTypeName(report.elementType) << ',' << report.config.recordCount << ','
+                 << result.samples.size() << ',' << stats->min << ',' << stats->median << ','
+                 << stats->p95 << ',' << stats->p99 << ',' << stats->mean << ',' << report.mibPerSecond(stats->median) << ','
+                 << result.pageCacheGrowth.median << ','
+                 << result.counters.pageFaults << ',' << result.counters.hardFaults << ',' << result.counters.readOperations << ','
+                 << result.counters.readBytes << ',' << result.counters.writeBytes << ',' << result.counters.cycles << ','
+                 << result.counters.userSeconds << ',' << result.counters.kernelSeconds << '\n';
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+void writeStatsJson(std::ostream& out, const SampleStats& stats) {
+    out << "{\"min_s\": " << stats.min << ", \"median_s\": " << stats.median << ", \"p95_s\": " << stats.p95
+        << ", \"p99_s\": " << stats.p99 << ", \"mean_s\": " << stats.mean << "}";
+}
+
+void writeCountersJson(std::ostream& out, const RunCounters& counters) {
+    out << "{\"page_faults\": " << counters.pageFaults << ", \"hard_faults\": " << counters.hardFaults
+        << ", \"read_operations\": " << counters.readOperations << ", \"read_bytes\": " << counters.readBytes
+        << ", \"write_bytes\": " << counters.writeBytes << ", \"cycles\": " << counters.cycles
+        << ", \"user_s\": " << counters.userSeconds << ", \"kernel_s\": " << counters.kernelSeconds << "}";
+}
+
+bool writeBenchmarkJson(const BenchmarkReport& report, const std::string& path) {
+    std::ofstream file(path, std::ios::trunc);
+    file << "{\"element_type\": \"" << ElementTypeName(report.elementType) << "\", \"element_bytes\": " << report.elementBytes
+         << ", \"records\": " << report.config.recordCount << ", \"warmup_runs\": " << report.config.warmupRuns
+         << ", \"repetitions\": " << report.config.repetitions << ", \"order_seed\": " << report.config.orderSeed
+         << ", \"modes\": [";
+    for (size_t i = 0; i < report.modes.size(); ++i) {
+        const ModeResult& result = report.modes[i];
+        file << (i ? "," : "") << "\n  {\"mode\": \"" << readModeName(result.mode) << "\", \"cache\": \""
+             << cacheStateName(result.cache) << "\", \"success\": "
+             << (result.success ? "true" : "false") << ", \"io\": ";
+        writeStatsJson(file, result.io);
+        file << ", \"compute\": ";
+        writeStatsJson(file, result.compute);
+        file << ", \"persist\": ";
+        writeStatsJson(file, result.persist);
+        file << ", \"teardown\": ";
+        writeStatsJson(file, result.teardown);
+        file << ", \"total\": ";
+        writeStatsJson(file, result.total);
+        file << ", \"median_mib_per_s\": " << report.mibPerSecond(result.total.median);
+        file << ", \"page_cache_growth_bytes\": ";
+        writeStatsJson(file, result.pageCacheGrowth);
+        file << ", \"counters\": ";
+        writeCountersJson(file, result.counters);
+        file << ", \"samples\": [";
+        for (size_t s = 0; s < result.samples.size(); ++s) {
+            file << (s ? ", " : "") << "[" << result.samples[s].io << ", " << result.samples[s].compute
+                 << ", " << result.samples[s].persist << ", " << result.samples[s].teardown << "]";
+        }
+        file << "]}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
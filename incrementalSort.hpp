@@ -0,0 +1,135 @@
+#ifndef INCREMENTAL_SORT_HPP
+#define INCREMENTAL_SORT_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "externalSort.hpp"
+#include "radixSort.hpp"
+
+// Sorts chunks on worker threads while the caller keeps receiving the next
+// ones, so by the time the input ends only the final merge is left. finish()
+// streams that merge out as it goes instead of materializing it first.
+template <typename T>
+class IncrementalSorter {
+public:
+    explicit IncrementalSorter(unsigned workerCount = 0);
+    ~IncrementalSorter();
+
+    void add(const T* records, size_t count);
+
+    // Same contract as ExternalSorter::finish().
+    template <typename Emit>
+    bool finish(size_t chunkRecords, Emit&& emit);
+
+    size_t chunkCount() const { return chunks.size(); }
+
+private:
+    void workerLoop();
+
+    std::vector<std::vector<T>> chunks;
+    std::deque<size_t> pending;
+    size_t inFlight = 0;
+    bool stopping = false;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::vector<std::thread> workers;
+};
+
+template <typename T>
+IncrementalSorter<T>::IncrementalSorter(unsigned workerCount) {
+    if (workerCount == 0) {
+        // hardware_concurrency() may be 0; clamp before leaving a core free.
+        workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;
+    }
+    for (unsigned i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&IncrementalSorter::workerLoop, this);
+    }
+}
+
+template <typename T>
+IncrementalSorter<T>::~IncrementalSorter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+template <typename T>
+void IncrementalSorter<T>::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        workAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) return;
+
+        // chunks may reallocate while we sort, so work on a moved-out copy.
+        size_t index = pending.front();
+        pending.pop_front();
+        ++inFlight;
+        std::vector<T> chunk = std::move(chunks[index]);
+        lock.unlock();
+
+        SortKeys(chunk.data(), chunk.size(), 1);
+
+        lock.lock();
+        chunks[index] = std::move(chunk);
+        --inFlight;
+        workDone.notify_all();
+    }
+}
+
+template <typename T>
+void IncrementalSorter<T>::add(const T* records, size_t count) {
+    if (count == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        chunks.emplace_back(records, records + count);
+        pending.push_back(chunks.size() - 1);
+    }
+    workAvailable.notify_one();
+}
+
+template <typename T>
+template <typename Emit>
+bool IncrementalSorter<T>::finish(size_t chunkRecords, Emit&& emit) {
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        workDone.wait(lock, [this] { return pending.empty() && inFlight == 0; });
+    }
+
+    if (chunks.empty()) return true;
+
+    std::vector<size_t> positions(chunks.size(), 0);
+    LoserTree<T> tree(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        tree.setHead(i, chunks[i].data());
+    }
+    tree.build();
+
+    std::vector<T> output;
+    output.reserve(chunkRecords);
+    while (!tree.empty()) {
+        output.push_back(tree.top());
+
+        const size_t source = tree.winner();
+        tree.replaceWinner(++positions[source] < chunks[source].size() ? &chunks[source][positions[source]] : nullptr);
+
+        if (output.size() == chunkRecords) {
+            if (!emit(output.data(), output.size())) return false;
+            output.clear();
+        }
+    }
+
+    return output.empty() || emit(output.data(), output.size());
+}
+
+#endif // INCREMENTAL_SORT_HPP
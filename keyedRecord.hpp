@@ -0,0 +1,28 @@
+#ifndef KEYED_RECORD_HPP
+#define KEYED_RECORD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// A fixed-size record ordered by the 64-bit key in its first eight bytes;
+// the rest is opaque payload that travels with the key. Sorters recognize
+// the sortKey() member and sort the keys instead of moving whole records
+// around on every pass.
+template <size_t Bytes>
+struct KeyedRecord {
+    static_assert(Bytes >= 2 * sizeof(int64_t) && Bytes % sizeof(int64_t) == 0, "Records hold a key and at least eight payload bytes");
+
+    int64_t key;
+    unsigned char payload[Bytes - sizeof(int64_t)];
+
+    int64_t sortKey() const { return key; }
+    bool operator<(const KeyedRecord& other) const { return key < other.key; }
+};
+
+using Record16 = KeyedRecord<16>;
+using Record64 = KeyedRecord<64>;
+using Record128 = KeyedRecord<128>;
+
+static_assert(sizeof(Record16) == 16 && sizeof(Record64) == 64 && sizeof(Record128) == 128, "Records are stored as is");
+
+#endif // KEYED_RECORD_HPP
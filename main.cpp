@@ -339,25 +339,299 @@ int main(int, char**)
             // Lab 2 Tab
             if (ImGui::BeginTabItem("File Mapping"))
             {
-                static std::pair<double, double> res = { 0.0, 0.0 };
+                static BenchmarkConfig benchmarkConfig;
+                static char benchmarkFile[MAX_PATH] = "data.bin";
+                static std::future<BenchmarkReport> benchmarkRun;
+                static BenchmarkReport benchmarkReport;
+                static std::future<std::vector<SortScalingPoint>> sortScalingRun;
+                static std::vector<SortScalingPoint> sortScaling;
+
+                if (ImGui::InputText("Input File", benchmarkFile, IM_ARRAYSIZE(benchmarkFile)))
+                {
+                    benchmarkConfig.filePath = benchmarkFile;
+                }
+                ImGui::InputScalar("Records##benchmark", ImGuiDataType_U64, &benchmarkConfig.recordCount);
+                ImGui::SameLine();
+                ImGui::TextDisabled("(0 = whole dataset)");
+                ImGui::Checkbox("Verify Checksums", &benchmarkConfig.verifyChecksums);
+                ImGui::InputScalar("Warmup Runs", ImGuiDataType_U32, &benchmarkConfig.warmupRuns);
+                ImGui::InputScalar("Repetitions", ImGuiDataType_U32, &benchmarkConfig.repetitions);
+                for (ReadMode mode : allReadModes)
+                {
+                    auto position = std::find(benchmarkConfig.modes.begin(), benchmarkConfig.modes.end(), mode);
+                    bool enabled = position != benchmarkConfig.modes.end();
+                    if (ImGui::Checkbox(readModeName(mode), &enabled))
+                    {
+                        if (enabled)
+                            benchmarkConfig.modes.push_back(mode);
+                        else
+                            benchmarkConfig.modes.erase(position);
+                    }
+                }
+                for (CacheState state : { CacheState::Cold, CacheState::Warm })
+                {
+                    auto position = std::find(benchmarkConfig.cacheStates.begin(), benchmarkConfig.cacheStates.end(), state);
+                    bool enabled = position != benchmarkConfig.cacheStates.end();
+                    if (ImGui::Checkbox(state == CacheState::Cold ? "Cold Cache" : "Warm Cache", &enabled))
+                    {
+                        if (enabled)
+                            benchmarkConfig.cacheStates.push_back(state);
+                        else
+                            benchmarkConfig.cacheStates.erase(position);
+                    }
+                    ImGui::SameLine();
+                }
+                ImGui::NewLine();
+                ImGui::InputScalar("Order Seed", ImGuiDataType_U64, &benchmarkConfig.orderSeed);
+                ImGui::InputScalar("Prefault Threads", ImGuiDataType_U32, &benchmarkConfig.prefaultThreads);
+                ImGui::InputScalar("Read Queue Depth", ImGuiDataType_U32, &benchmarkConfig.ioQueueDepth);
+                ImGui::InputScalar("Read Block Bytes", ImGuiDataType_U64, &benchmarkConfig.ioBlockBytes);
+                ImGui::InputScalar("Unbuffered Buffers", ImGuiDataType_U32, &benchmarkConfig.unbufferedBuffers);
+                ImGui::InputScalar("Flush Range Bytes", ImGuiDataType_U64, &benchmarkConfig.flushRangeBytes);
+                ImGui::InputScalar("Read-Ahead Bytes", ImGuiDataType_U64, &benchmarkConfig.readAheadBytes);
+                ImGui::InputScalar("Sort Threads", ImGuiDataType_U32, &benchmarkConfig.sortThreads);
+
+                if (!benchmarkRun.valid() && !sortScalingRun.valid() && ImGui::Button("Run"))
+                {
+                    benchmarkRun = std::async(std::launch::async, benchmark, benchmarkConfig);
+                }
+                if (!benchmarkRun.valid() && !sortScalingRun.valid())
+                {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Sort Scaling"))
+                        sortScalingRun = std::async(std::launch::async, sortScalingSweep, benchmarkConfig, 0u);
+                }
+                if (benchmarkRun.valid())
+                {
+                    if (benchmarkRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        benchmarkReport = benchmarkRun.get();
+                    else
+                        ImGui::Text("Running...");
+                }
+                if (sortScalingRun.valid())
+                {
+                    if (sortScalingRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        sortScaling = sortScalingRun.get();
+                    else
+                        ImGui::Text("Measuring sort scaling...");
+                }
 
-                if (ImGui::Button("Run"))
+                if (!sortScaling.empty() && ImGui::BeginTable("SortScalingTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
                 {
-                    res = benchmark();
+                    ImGui::TableSetupColumn("Threads");
+                    ImGui::TableSetupColumn("Mode");
+                    ImGui::TableSetupColumn("Compute Median (s)");
+                    ImGui::TableSetupColumn("Total Median (s)");
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& point : sortScaling)
+                    {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%u", point.threads);
+                        ImGui::TableNextColumn(); ImGui::Text("%s (%s)", readModeName(point.mode), cacheStateName(point.cache));
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", point.computeMedian);
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", point.totalMedian);
+                    }
+                    ImGui::EndTable();
                 }
 
-                ImGui::Text("Traditional File Reading: %f seconds", res.first);
-                ImGui::Text("Memory-Mapped File Reading: %f seconds", res.second);
+                if (!benchmarkReport.modes.empty())
+                {
+                    ImGui::Text("%zu %s records (%zu bytes each)", benchmarkReport.config.recordCount,
+                                ElementTypeName(benchmarkReport.elementType), benchmarkReport.elementBytes);
+                    if (ImGui::BeginTable("BenchmarkTable", 10, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                    {
+                        ImGui::TableSetupColumn("Mode");
+                        ImGui::TableSetupColumn("I/O Median (s)");
+                        ImGui::TableSetupColumn("Compute Median (s)");
+                        ImGui::TableSetupColumn("Persist Median (s)");
+                        ImGui::TableSetupColumn("Total Min (s)");
+                        ImGui::TableSetupColumn("Total Median (s)");
+                        ImGui::TableSetupColumn("Total p95 (s)");
+                        ImGui::TableSetupColumn("Total p99 (s)");
+                        ImGui::TableSetupColumn("Page Cache (MiB)");
+                        ImGui::TableSetupColumn("MiB/s");
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& result : benchmarkReport.modes)
+                        {
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn(); ImGui::Text("%s (%s)%s", readModeName(result.mode), cacheStateName(result.cache), result.success ? "" : " (failed)");
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.io.median);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.compute.median);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.persist.median);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.total.min);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.total.median);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.total.p95);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.total.p99);
+                            ImGui::TableNextColumn(); ImGui::Text("%+.1f", result.pageCacheGrowth.median / (1024.0 * 1024.0));
+                            ImGui::TableNextColumn(); ImGui::Text("%.1f", benchmarkReport.mibPerSecond(result.total.median));
+                        }
+                        ImGui::EndTable();
+                    }
+
+                    // Medians per run: high kernel time with many hard faults points at
+                    // fault-bound modes, read bytes at I/O-bound ones, and cycles well
+                    // above user + kernel time at cache misses.
+                    if (ImGui::BeginTable("CounterTable", 8, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                    {
+                        ImGui::TableSetupColumn("Mode");
+                        ImGui::TableSetupColumn("Page Faults");
+                        ImGui::TableSetupColumn("Hard Faults");
+                        ImGui::TableSetupColumn("Read Ops");
+                        ImGui::TableSetupColumn("Read (MiB)");
+                        ImGui::TableSetupColumn("Cycles (M)");
+                        ImGui::TableSetupColumn("User (s)");
+                        ImGui::TableSetupColumn("Kernel (s)");
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& result : benchmarkReport.modes)
+                        {
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn(); ImGui::Text("%s (%s)", readModeName(result.mode), cacheStateName(result.cache));
+                            ImGui::TableNextColumn(); ImGui::Text("%.0f", result.counters.pageFaults);
+                            ImGui::TableNextColumn(); ImGui::Text("%.0f", result.counters.hardFaults);
+                            ImGui::TableNextColumn(); ImGui::Text("%.0f", result.counters.readOperations);
+                            ImGui::TableNextColumn(); ImGui::Text("%.1f", result.counters.readBytes / (1024.0 * 1024.0));
+                            ImGui::TableNextColumn(); ImGui::Text("%.1f", result.counters.cycles / 1e6);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.counters.userSeconds);
+                            ImGui::TableNextColumn(); ImGui::Text("%.4f", result.counters.kernelSeconds);
+                        }
+                        ImGui::EndTable();
+                    }
+
+                    if (ImGui::Button("Export CSV"))
+                    {
+                        writeBenchmarkCsv(benchmarkReport, "benchmark.csv");
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Export JSON"))
+                    {
+                        writeBenchmarkJson(benchmarkReport, "benchmark.json");
+                    }
+                }
 
                 ImGui::EndTabItem();
             }
 
             // Lab 3 Tab
+            static PipelineConfig pipelineConfig;
+
             if (ImGui::BeginTabItem("Data pipeline"))
             {
-                if (ImGui::Button("Run"))
+                static int transportIndex = 0;
+                const char* transports[] = { "Named pipe", "Shared-memory ring" };
+                if (ImGui::Combo("Transport", &transportIndex, transports, IM_ARRAYSIZE(transports)))
+                {
+                    pipelineConfig.transport = transportIndex == 1 ? PipelineTransport::SharedRing : PipelineTransport::Pipe;
+                }
+                ImGui::InputScalar("Records", ImGuiDataType_U64, &pipelineConfig.recordCount);
+                ImGui::InputScalar("Records per Chunk", ImGuiDataType_U32, &pipelineConfig.chunkRecords);
+                static int distributionIndex = 0;
+                const char* distributions[] = { "Uniform", "Zipf", "Sorted", "Reverse sorted", "Nearly sorted", "Few unique" };
+                if (ImGui::Combo("Distribution", &distributionIndex, distributions, IM_ARRAYSIZE(distributions)))
+                {
+                    pipelineConfig.distribution = static_cast<Distribution>(distributionIndex);
+                }
+                ImGui::InputScalar("Seed", ImGuiDataType_U64, &pipelineConfig.seed);
+                ImGui::InputScalar("Value Range", ImGuiDataType_U64, &pipelineConfig.valueRange);
+                static int outputFormatIndex = 1;
+                const char* outputFormats[] = { "None", "Text", "Binary" };
+                if (ImGui::Combo("Output Format", &outputFormatIndex, outputFormats, IM_ARRAYSIZE(outputFormats)))
+                {
+                    pipelineConfig.outputFormat = static_cast<OutputFormat>(outputFormatIndex);
+                }
+                static char outputPath[MAX_PATH] = "";
+                if (ImGui::InputText("Output File", outputPath, IM_ARRAYSIZE(outputPath)))
                 {
-                    LaunchDataPipeline();
+                    pipelineConfig.outputPath = outputPath;
+                }
+                ImGui::Checkbox("Sort While Receiving", &pipelineConfig.incrementalSort);
+                ImGui::Checkbox("External Merge Sort", &pipelineConfig.externalSort);
+                if (pipelineConfig.externalSort)
+                {
+                    ImGui::InputScalar("Records per Run", ImGuiDataType_U64, &pipelineConfig.runRecords);
+                    ImGui::InputScalar("Merge Fan-in", ImGuiDataType_U32, &pipelineConfig.mergeFanIn);
+                }
+                ImGui::InputScalar("Sorter Processes", ImGuiDataType_U32, &pipelineConfig.sorterCount);
+                if (pipelineConfig.sorterCount > 1)
+                {
+                    ImGui::Checkbox("Merge Partitions", &pipelineConfig.mergePartitions);
+                }
+
+                static std::future<PipelineReport> pipelineRun;
+                static PipelineReport pipelineReport;
+                static std::future<std::vector<ScalingPoint>> scalingRun;
+                static std::vector<ScalingPoint> scalingPoints;
+
+                if (!pipelineRun.valid() && !scalingRun.valid())
+                {
+                    if (ImGui::Button("Run"))
+                        pipelineRun = std::async(std::launch::async, LaunchDataPipeline, pipelineConfig);
+                    ImGui::SameLine();
+                    if (ImGui::Button("Scaling Sweep"))
+                        scalingRun = std::async(std::launch::async, RunSorterScalingSweep, pipelineConfig, 0u);
+                }
+                if (pipelineRun.valid())
+                {
+                    if (pipelineRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        pipelineReport = pipelineRun.get();
+                    else
+                        ImGui::Text("Running...");
+                }
+                if (scalingRun.valid())
+                {
+                    if (scalingRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        scalingPoints = scalingRun.get();
+                    else
+                        ImGui::Text("Sweeping sorter counts...");
+                }
+
+                if (!scalingPoints.empty() && ImGui::BeginTable("ScalingTable", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                {
+                    ImGui::TableSetupColumn("Sorters");
+                    ImGui::TableSetupColumn("Wall Time (s)");
+                    ImGui::TableSetupColumn("Speedup");
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& point : scalingPoints)
+                    {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%u", point.sorters);
+                        ImGui::TableNextColumn(); ImGui::Text("%.3f%s", point.wallSeconds, point.success ? "" : " (failed)");
+                        ImGui::TableNextColumn(); ImGui::Text("%.2fx", point.wallSeconds > 0 ? scalingPoints.front().wallSeconds / point.wallSeconds : 0.0);
+                    }
+                    ImGui::EndTable();
+                }
+
+                if (!pipelineReport.stages.empty())
+                {
+                    ImGui::Text("%s in %.3f s, startup %.2f ms", pipelineReport.success ? "Completed" : "Failed",
+                        pipelineReport.wallSeconds, pipelineReport.startupSeconds * 1000.0);
+
+                    if (ImGui::BeginTable("PipelineStagesTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+                    {
+                        ImGui::TableSetupColumn("Stage");
+                        ImGui::TableSetupColumn("Exit Code");
+                        ImGui::TableSetupColumn("Ready (ms)");
+                        ImGui::TableSetupColumn("Wall Time (s)");
+                        ImGui::TableSetupColumn("Peak RSS (KiB)");
+                        ImGui::TableHeadersRow();
+
+                        for (const auto& stage : pipelineReport.stages)
+                        {
+                            ImGui::TableNextRow();
+                            ImGui::TableNextColumn(); ImGui::Text("%s", stage.name.c_str());
+                            ImGui::TableNextColumn(); ImGui::Text("%lu", stage.exitCode);
+                            ImGui::TableNextColumn(); ImGui::Text("%.2f", stage.readySeconds * 1000.0);
+                            ImGui::TableNextColumn(); ImGui::Text("%.3f", stage.wallSeconds);
+                            ImGui::TableNextColumn(); ImGui::Text("%zu", stage.peakWorkingSetBytes / 1024);
+                        }
+                        ImGui::EndTable();
+                    }
+
+                    if (!pipelineReport.reportPath.empty())
+                        ImGui::Text("Telemetry report: %s", pipelineReport.reportPath.c_str());
                 }
 
                 ImGui::EndTabItem();
@@ -369,6 +643,14 @@ int main(int, char**)
             static size_t blockSize = 1024;
             static int writerThreadsCount = 3;
             static int readerThreadsCount = 5;
+            static int readPolicyIndex = 0;
+            static int workloadIndex = 1;
+            static WorkloadConfig workload;
+            static size_t transferSize = 1024;
+            static SharedMemoryLayout sharedMemoryLayout;
+            static char segmentName[64] = "";
+            static std::future<std::vector<SharedMemoryScalingPoint>> sharedMemoryScalingRun;
+            static std::vector<SharedMemoryScalingPoint> sharedMemoryScaling;
             static SharedMemory* sharedMemory = nullptr;
             static std::atomic<bool> running = false;
             static std::vector<std::thread> writerThreads;
@@ -380,13 +662,35 @@ int main(int, char**)
                 ImGui::InputInt("Block Size (bytes)", (int*)&blockSize);
                 ImGui::InputInt("Writer Threads per Block", &writerThreadsCount);
                 ImGui::InputInt("Reader Threads per Block", &readerThreadsCount);
+                const char* readPolicies[] = { "Mutex", "Seqlock", "Shared lock (SRW)", "Writer-preferring" };
+                ImGui::Combo("Read Policy", &readPolicyIndex, readPolicies, IM_ARRAYSIZE(readPolicies));
+                ImGui::InputScalar("Transfer Size (bytes)", ImGuiDataType_U64, &transferSize);
+                ImGui::InputScalar("Block Alignment (bytes)", ImGuiDataType_U64, &sharedMemoryLayout.blockAlignment);
+                ImGui::Checkbox("Sharded Statistics", &sharedMemoryLayout.shardedStats);
+                ImGui::InputText("Segment Name", segmentName, IM_ARRAYSIZE(segmentName));
+                ImGui::SameLine();
+                ImGui::TextDisabled("(empty = private to this process)");
+                ImGui::Checkbox("Max Throughput", &workload.maxThroughput);
+                if (!workload.maxThroughput) {
+                    const char* workloads[] = { "None", "Busy spin", "Checksum" };
+                    if (ImGui::Combo("Workload", &workloadIndex, workloads, IM_ARRAYSIZE(workloads))) {
+                        workload.kind = static_cast<Workload>(workloadIndex);
+                    }
+                    if (workload.kind == Workload::Spin) {
+                        ImGui::InputScalar("Spin (ns)", ImGuiDataType_U64, &workload.spinNanoseconds);
+                    }
+                }
 
-                if (!running && ImGui::Button("Run")) {
-                    running = true;
-                    sharedMemory = new SharedMemory(memorySize, blockSize);
+                if (!running && !sharedMemoryScalingRun.valid() && ImGui::Button("Run")) {
+                    sharedMemory = new SharedMemory(segmentName, memorySize, blockSize, static_cast<ReadPolicy>(readPolicyIndex), workload, sharedMemoryLayout);
+                    if (!sharedMemory->isOpen()) {
+                        delete sharedMemory;
+                        sharedMemory = nullptr;
+                    } else {
+                        running = true;
 
-                    std::vector<int> data(64, 42); // 64 integers with value 42
-                    const size_t numberOfBlocks = memorySize / blockSize;
+                        std::vector<char> data(std::min(transferSize, blockSize), 42);
+                        const size_t numberOfBlocks = memorySize / blockSize;
 
                         auto runTask = std::async(std::launch::async, [&]() {
                             for (size_t i = 0; i < numberOfBlocks; ++i) {
@@ -399,6 +703,38 @@ int main(int, char**)
                                 }
                             }
                         });
+                    }
+                }
+
+                if (!running && !sharedMemoryScalingRun.valid()) {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Thread Scaling"))
+                        sharedMemoryScalingRun = std::async(std::launch::async, sharedMemoryScalingSweep, memorySize, blockSize,
+                                                            static_cast<ReadPolicy>(readPolicyIndex), transferSize, 64u, 1.0);
+                }
+                if (sharedMemoryScalingRun.valid()) {
+                    if (sharedMemoryScalingRun.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+                        sharedMemoryScaling = sharedMemoryScalingRun.get();
+                    else
+                        ImGui::Text("Measuring thread scaling...");
+                }
+                if (!sharedMemoryScaling.empty() && ImGui::BeginTable("SharedMemoryScalingTable", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+                    ImGui::TableSetupColumn("Threads");
+                    ImGui::TableSetupColumn("Layout");
+                    ImGui::TableSetupColumn("Write GB/s");
+                    ImGui::TableSetupColumn("Read GB/s");
+                    ImGui::TableSetupColumn("Blocked (s)");
+                    ImGui::TableHeadersRow();
+
+                    for (const auto& point : sharedMemoryScaling) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn(); ImGui::Text("%u", point.threads);
+                        ImGui::TableNextColumn(); ImGui::Text("%s", point.aligned ? "aligned, sharded" : "packed, shared");
+                        ImGui::TableNextColumn(); ImGui::Text("%.3f", point.writeBandwidth / 1e9);
+                        ImGui::TableNextColumn(); ImGui::Text("%.3f", point.readBandwidth / 1e9);
+                        ImGui::TableNextColumn(); ImGui::Text("%.4f", point.blockedSeconds);
+                    }
+                    ImGui::EndTable();
                 }
 
                 if (running && ImGui::Button("Stop")) {
@@ -430,14 +766,21 @@ int main(int, char**)
 
                 if (sharedMemory) {
                     const size_t numberOfBlocks = memorySize / blockSize;
-                    ImGui::Text("Bandwidth: %f bytes/sec", sharedMemory->getBandwidth());
+                    ImGui::Text("Write bandwidth (%s reads, %s workload): %.3f GB/s", readPolicyName(sharedMemory->getReadPolicy()),
+                                workloadName(sharedMemory->getWorkload()), sharedMemory->getBandwidth() / 1e9);
+                    ImGui::Text("Read bandwidth: %.3f GB/s", sharedMemory->getReadBandwidth() / 1e9);
+                    if (!sharedMemory->getSegmentName().empty())
+                        ImGui::Text("Segment %s: %llu abandoned block locks recovered", sharedMemory->getSegmentName().c_str(),
+                                    static_cast<unsigned long long>(sharedMemory->getAbandonedLocks()));
 
                     ImGui::BeginTable("SharedMemoryTable", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg);
                     for (size_t i = 0; i < numberOfBlocks; ++i) {
                         ImGui::TableNextColumn();
                         ImVec4 color = sharedMemory->isBlockAccessed(i) ? ImVec4(1.0f, 0.0f, 0.0f, 1.0f) : ImVec4(0.0f, 1.0f, 0.0f, 1.0f);
                         ImGui::TableSetBgColor(ImGuiTableBgTarget_CellBg, ImGui::GetColorU32(color));
-                        ImGui::Text("Block %zu\nActive Time: %.5f\nBlocked Time: %.5f", i, sharedMemory->getActiveTime(i), sharedMemory->getBlockedTime(i));
+                        ImGui::Text("Block %zu\nActive Time: %.5f\nBlocked Time: %.5f\nReaders Waiting on Writers: %.5f\nReaders Waiting on Readers: %.5f\nRead Retries: %llu",
+                                    i, sharedMemory->getActiveTime(i), sharedMemory->getBlockedTime(i), sharedMemory->getReaderWaitOnWriters(i),
+                                    sharedMemory->getReaderWaitOnReaders(i), static_cast<unsigned long long>(sharedMemory->getReadRetries(i)));
                     }
                     ImGui::EndTable();
                 }
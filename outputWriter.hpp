@@ -0,0 +1,123 @@
+#ifndef OUTPUT_WRITER_HPP
+#define OUTPUT_WRITER_HPP
+
+#include <windows.h>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "pipelineStage.hpp"
+
+#define OUTPUT_BUFFER_BYTES (4 * 1024 * 1024)
+#define MAX_FORMATTED_RECORD_CHARS 24
+
+enum class OutputFormat {
+    None,
+    Text,
+    Binary,
+};
+
+const char* OutputFormatName(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::None: return "none";
+    case OutputFormat::Text: return "text";
+    case OutputFormat::Binary: return "binary";
+    }
+    return "text";
+}
+
+OutputFormat ParseOutputFormat(const std::string& name) {
+    if (name == "none") return OutputFormat::None;
+    if (name == "binary") return OutputFormat::Binary;
+    return OutputFormat::Text;
+}
+
+// Formats records into one large reusable buffer and hands it to the OS
+// with a single WriteFile per buffer. Text mode uses std::to_chars; binary
+// mode passes the records through unchanged and skips the buffer entirely
+// for blocks larger than it.
+class OutputWriter {
+public:
+    OutputWriter(HANDLE hOutput, OutputFormat format, size_t bufferBytes = OUTPUT_BUFFER_BYTES);
+    ~OutputWriter();
+
+    template <typename T>
+    bool write(const T* records, size_t count);
+    bool flush();
+
+    uint64_t bytesWritten() const { return totalBytes; }
+    double writeSeconds() const { return blockedSeconds; }
+
+private:
+    bool writeAll(const char* data, size_t size);
+
+    HANDLE hOutput;
+    OutputFormat format;
+    std::vector<char> buffer;
+    size_t used = 0;
+    uint64_t totalBytes = 0;
+    double blockedSeconds = 0.0;
+};
+
+OutputWriter::OutputWriter(HANDLE hOutput, OutputFormat format, size_t bufferBytes)
+    : hOutput(hOutput), format(format), buffer(format == OutputFormat::None ? 0 : bufferBytes) {}
+
+OutputWriter::~OutputWriter() {
+    flush();
+}
+
+bool OutputWriter::writeAll(const char* data, size_t size) {
+    while (size > 0) {
+        DWORD toWrite = static_cast<DWORD>(size < 0x40000000 ? size : 0x40000000);
+        DWORD written = 0;
+        const int64_t start = PipelineTimestamp();
+        const BOOL ok = WriteFile(hOutput, data, toWrite, &written, NULL);
+        blockedSeconds += PipelineSeconds(start, PipelineTimestamp());
+        if (!ok || written == 0) {
+            return false;
+        }
+        data += written;
+        size -= written;
+        totalBytes += written;
+    }
+    return true;
+}
+
+bool OutputWriter::flush() {
+    bool ok = writeAll(buffer.data(), used);
+    used = 0;
+    return ok;
+}
+
+template <typename T>
+bool OutputWriter::write(const T* records, size_t count) {
+    if (format == OutputFormat::None) {
+        return true;
+    }
+
+    if (format == OutputFormat::Binary) {
+        const char* bytes = reinterpret_cast<const char*>(records);
+        const size_t size = count * sizeof(T);
+        if (used + size > buffer.size()) {
+            if (!flush()) return false;
+            if (size >= buffer.size()) return writeAll(bytes, size);
+        }
+        std::memcpy(buffer.data() + used, bytes, size);
+        used += size;
+        return true;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (buffer.size() - used < MAX_FORMATTED_RECORD_CHARS && !flush()) {
+            return false;
+        }
+        char* cursor = buffer.data() + used;
+        cursor = std::to_chars(cursor, buffer.data() + buffer.size(), records[i]).ptr;
+        *cursor++ = ' ';
+        used = cursor - buffer.data();
+    }
+    return true;
+}
+
+#endif // OUTPUT_WRITER_HPP
@@ -0,0 +1,105 @@
+#ifndef PIPELINE_STAGE_HPP
+#define PIPELINE_STAGE_HPP
+
+#include <windows.h>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Command line options shared by the pipeline stage executables.
+// Options are "--name value" pairs or bare "--flag" switches.
+class StageArgs {
+public:
+    StageArgs(int argc, char** argv);
+
+    bool has(const std::string& name) const;
+    std::string getString(const std::string& name, const std::string& fallback) const;
+    uint64_t getSize(const std::string& name, uint64_t fallback) const;
+
+private:
+    const std::string* find(const std::string& name) const;
+
+    std::vector<std::string> args;
+};
+
+StageArgs::StageArgs(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i) {
+        args.emplace_back(argv[i]);
+    }
+}
+
+const std::string* StageArgs::find(const std::string& name) const {
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        if (args[i] == name) {
+            return &args[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+bool StageArgs::has(const std::string& name) const {
+    for (const auto& arg : args) {
+        if (arg == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string StageArgs::getString(const std::string& name, const std::string& fallback) const {
+    const std::string* value = find(name);
+    return value ? *value : fallback;
+}
+
+// Accepts plain numbers and K/M/G suffixes (powers of 1024).
+uint64_t StageArgs::getSize(const std::string& name, uint64_t fallback) const {
+    const std::string* value = find(name);
+    if (!value || value->empty()) {
+        return fallback;
+    }
+
+    char* end = nullptr;
+    uint64_t result = std::strtoull(value->c_str(), &end, 10);
+    switch (*end) {
+    case 'K': case 'k': result <<= 10; break;
+    case 'M': case 'm': result <<= 20; break;
+    case 'G': case 'g': result <<= 30; break;
+    default: break;
+    }
+    return result;
+}
+
+// QueryPerformanceCounter is consistent across processes, so the launcher
+// can hand its start time to the stages (--epoch) and they can report
+// latencies relative to the start of the whole pipeline.
+int64_t PipelineTimestamp() {
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return counter.QuadPart;
+}
+
+double PipelineSeconds(int64_t from, int64_t to) {
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    return static_cast<double>(to - from) / static_cast<double>(frequency.QuadPart);
+}
+
+int64_t PipelineEpoch(const StageArgs& args) {
+    const std::string epoch = args.getString("--epoch", "");
+    return epoch.empty() ? PipelineTimestamp() : std::strtoll(epoch.c_str(), nullptr, 10);
+}
+
+// Tells the supervisor that this stage is connected and about to stream.
+// The event handle is inherited from the launcher; running a stage by hand
+// simply skips the signal.
+void SignalReady(const StageArgs& args) {
+    const std::string handle = args.getString("--ready-handle", "");
+    if (handle.empty()) return;
+
+    HANDLE hReady = reinterpret_cast<HANDLE>(static_cast<uintptr_t>(std::strtoull(handle.c_str(), nullptr, 10)));
+    SetEvent(hReady);
+    CloseHandle(hReady);
+}
+
+#endif // PIPELINE_STAGE_HPP
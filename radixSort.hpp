@@ -0,0 +1,249 @@
+#ifndef RADIX_SORT_HPP
+#define RADIX_SORT_HPP
+
+#include <algorithm>
+#include <array>
+#include <barrier>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define RADIX_MIN_PARALLEL_RECORDS (1 << 16)
+#define RADIX_MIN_RECORDS_PER_THREAD (1 << 18)
+#define RADIX_WRITE_COMBINE_BYTES 128
+
+// Maps a value to an unsigned key of the same width whose unsigned order is
+// the value's order: signed integers get their sign bit flipped, floats
+// their sign bit set or, when negative, all bits inverted. Records sort by
+// the key their sortKey() returns.
+template <typename T>
+auto RadixKeyOf(const T& value) {
+    if constexpr (std::is_integral_v<T>) {
+        using Key = std::make_unsigned_t<T>;
+        constexpr Key signFlip = std::is_signed_v<T> ? Key(1) << (sizeof(T) * 8 - 1) : Key(0);
+        return static_cast<Key>(static_cast<Key>(value) ^ signFlip);
+    } else if constexpr (std::is_floating_point_v<T>) {
+        using Key = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+        constexpr Key signBit = Key(1) << (sizeof(T) * 8 - 1);
+        const Key bits = std::bit_cast<Key>(value);
+        return static_cast<Key>((bits & signBit) ? ~bits : bits | signBit);
+    } else {
+        return RadixKeyOf(value.sortKey());
+    }
+}
+
+template <typename T>
+concept RadixScalar = (std::is_integral_v<T> || std::is_floating_point_v<T>) && (sizeof(T) == 4 || sizeof(T) == 8);
+
+template <typename T>
+concept SortKeyed = requires(const T& record) { { record.sortKey() } -> RadixScalar; };
+
+// A record's key next to its position, the unit the key-extracting sort
+// moves around instead of the record itself.
+template <typename K>
+struct ExtractedKey {
+    K key;
+    uint64_t index;
+
+    K sortKey() const { return key; }
+};
+
+// Parallel LSD radix sort over 8-bit digits.
+//
+// Every pass splits the source into one contiguous block per thread. Each
+// thread builds a histogram of its block, the histograms are prefix-summed
+// in (digit, thread) order so that the scatter stays stable, and each
+// thread then scatters through small per-digit write-combining buffers so
+// that stores to the destination go out in cache-line sized bursts instead
+// of 256 interleaved streams. Passes where every key has the same digit are
+// skipped.
+template <typename T>
+class ParallelRadixSorter {
+    static_assert(RadixScalar<T> || SortKeyed<T>, "Radix sort supports 32/64-bit integers, floats and sortKey() records");
+
+public:
+    explicit ParallelRadixSorter(unsigned threadCount = 0);
+
+    void sort(T* data, size_t size);
+
+private:
+    using Key = decltype(RadixKeyOf(std::declval<const T&>()));
+
+    static constexpr unsigned RADIX = 256;
+    static constexpr unsigned PASSES = sizeof(Key);
+    static constexpr size_t WC_RECORDS = std::max<size_t>(RADIX_WRITE_COMBINE_BYTES / sizeof(T), 1);
+
+    static unsigned digitOf(const T& value, unsigned pass) {
+        return static_cast<unsigned>((RadixKeyOf(value) >> (pass * 8)) & 0xFF);
+    }
+
+    struct alignas(64) ThreadState {
+        std::array<size_t, RADIX> counts;
+        std::array<size_t, RADIX> offsets;
+        std::array<uint32_t, RADIX> fill;
+        alignas(64) T combine[RADIX][WC_RECORDS];
+    };
+
+    void histogram(unsigned thread, unsigned pass);
+    void scatter(unsigned thread, unsigned pass);
+    void computeOffsets();
+
+    unsigned threadCount;
+    unsigned workerCount = 1;
+    std::vector<ThreadState> states;
+    T* source = nullptr;
+    T* destination = nullptr;
+    size_t size = 0;
+    bool skipPass = false;
+};
+
+template <typename T>
+ParallelRadixSorter<T>::ParallelRadixSorter(unsigned threadCount)
+    : threadCount(threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency())) {}
+
+template <typename T>
+void ParallelRadixSorter<T>::histogram(unsigned thread, unsigned pass) {
+    const size_t begin = size * thread / workerCount;
+    const size_t end = size * (thread + 1) / workerCount;
+    auto& counts = states[thread].counts;
+    counts.fill(0);
+    for (size_t i = begin; i < end; ++i) {
+        ++counts[digitOf(source[i], pass)];
+    }
+}
+
+template <typename T>
+void ParallelRadixSorter<T>::computeOffsets() {
+    size_t offset = 0;
+    skipPass = false;
+    for (unsigned digit = 0; digit < RADIX; ++digit) {
+        size_t digitTotal = 0;
+        for (unsigned thread = 0; thread < workerCount; ++thread) {
+            states[thread].offsets[digit] = offset;
+            offset += states[thread].counts[digit];
+            digitTotal += states[thread].counts[digit];
+        }
+        if (digitTotal == size) {
+            skipPass = true;
+        }
+    }
+}
+
+template <typename T>
+void ParallelRadixSorter<T>::scatter(unsigned thread, unsigned pass) {
+    const size_t begin = size * thread / workerCount;
+    const size_t end = size * (thread + 1) / workerCount;
+    ThreadState& state = states[thread];
+    state.fill.fill(0);
+
+    for (size_t i = begin; i < end; ++i) {
+        const T& value = source[i];
+        const unsigned digit = digitOf(value, pass);
+        uint32_t& fill = state.fill[digit];
+        state.combine[digit][fill] = value;
+        if (++fill == WC_RECORDS) {
+            std::memcpy(destination + state.offsets[digit], state.combine[digit], sizeof(state.combine[digit]));
+            state.offsets[digit] += WC_RECORDS;
+            fill = 0;
+        }
+    }
+
+    for (unsigned digit = 0; digit < RADIX; ++digit) {
+        if (state.fill[digit] > 0) {
+            std::memcpy(destination + state.offsets[digit], state.combine[digit], state.fill[digit] * sizeof(T));
+        }
+    }
+}
+
+template <typename T>
+void ParallelRadixSorter<T>::sort(T* data, size_t count) {
+    if (count < 2) return;
+
+    std::unique_ptr<T[]> buffer(new T[count]);
+    size = count;
+    source = data;
+    destination = buffer.get();
+
+    workerCount = static_cast<unsigned>(std::clamp<size_t>(count / RADIX_MIN_RECORDS_PER_THREAD, 1, threadCount));
+    states.resize(workerCount);
+
+    // Phase completions run on exactly one thread while the others wait,
+    // so the shared offsets/skip flag and the buffer swap need no locking.
+    auto afterHistogram = [this]() noexcept { computeOffsets(); };
+    auto afterScatter = [this]() noexcept {
+        if (!skipPass) std::swap(source, destination);
+    };
+    std::barrier histogramDone(workerCount, afterHistogram);
+    std::barrier scatterDone(workerCount, afterScatter);
+
+    auto worker = [&](unsigned thread) {
+        for (unsigned pass = 0; pass < PASSES; ++pass) {
+            histogram(thread, pass);
+            histogramDone.arrive_and_wait();
+            if (!skipPass) {
+                scatter(thread, pass);
+            }
+            scatterDone.arrive_and_wait();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned thread = 1; thread < workerCount; ++thread) {
+        threads.emplace_back(worker, thread);
+    }
+    worker(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    if (source != data) {
+        std::memcpy(data, source, count * sizeof(T));
+    }
+}
+
+// Radix-sorts (key, position) pairs and then gathers the records into their
+// sorted order, so a wide record is moved once instead of once per pass.
+// Stable, like the radix sort itself.
+template <typename T>
+void SortByExtractedKey(T* data, size_t size, unsigned threadCount) {
+    using Extracted = ExtractedKey<decltype(std::declval<const T&>().sortKey())>;
+    std::unique_ptr<Extracted[]> keys(new Extracted[size]);
+    for (size_t i = 0; i < size; ++i) {
+        keys[i] = { data[i].sortKey(), i };
+    }
+    ParallelRadixSorter<Extracted>(threadCount).sort(keys.get(), size);
+
+    std::unique_ptr<T[]> sorted(new T[size]);
+    for (size_t i = 0; i < size; ++i) {
+        sorted[i] = data[keys[i].index];
+    }
+    std::memcpy(data, sorted.get(), size * sizeof(T));
+}
+
+// Picks the kernel at compile time: radix for 32/64-bit integers and
+// floats, key extraction for records with a sortKey(), std::sort for
+// anything else and for inputs too small to amortize the scratch buffers.
+template <typename T>
+void SortKeys(T* data, size_t size, unsigned threadCount = 0) {
+    if constexpr (RadixScalar<T>) {
+        if (size >= RADIX_MIN_PARALLEL_RECORDS) {
+            ParallelRadixSorter<T>(threadCount).sort(data, size);
+            return;
+        }
+        std::sort(data, data + size);
+    } else if constexpr (SortKeyed<T>) {
+        if (size >= RADIX_MIN_PARALLEL_RECORDS) {
+            SortByExtractedKey(data, size, threadCount);
+            return;
+        }
+        std::stable_sort(data, data + size, [](const T& a, const T& b) { return a.sortKey() < b.sortKey(); });
+    } else {
+        std::sort(data, data + size);
+    }
+}
+
+#endif // RADIX_SORT_HPP
@@ -1,146 +1,811 @@
 #pragma once
 
 #include <windows.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <chrono>
 #include <iostream>
+#include <memory>
+#include <new>
+#include <string>
 #include <thread>
 
+// Mutex: readers take the block's mutex like writers do, so they serialize
+// behind each other and behind writers. Seqlock: writers still serialize on
+// the mutex but bump the block's sequence around the copy; readers copy
+// optimistically and retry when the sequence moved, so they never block.
+// SharedLock: a slim reader/writer lock (what std::shared_mutex is on
+// Windows), readers share it and only wait for writers. WriterPreferring:
+// like SharedLock, but new readers queue behind waiting writers so a
+// steady stream of readers cannot starve them.
+enum class ReadPolicy {
+    Mutex,
+    Seqlock,
+    SharedLock,
+    WriterPreferring,
+};
+
+inline const char* readPolicyName(ReadPolicy policy) {
+    switch (policy) {
+    case ReadPolicy::Mutex: return "mutex";
+    case ReadPolicy::Seqlock: return "seqlock";
+    case ReadPolicy::SharedLock: return "shared lock";
+    case ReadPolicy::WriterPreferring: return "writer-preferring";
+    }
+    return "mutex";
+}
+
+// A reader/writer lock in one 32-bit word, waited on with WaitOnAddress:
+// bit 31 is the writer, bits 0-15 count readers, and bits 16-30 change on
+// every writer release so a waiter cannot miss a release that put the
+// word back to a value it already saw. Writers announce themselves in
+// writersWaiting first, which holds off new readers.
+class WriterPreferringLock {
+public:
+    void lock();
+    void unlock();
+    void lockShared();
+    void unlockShared();
+
+private:
+    static constexpr uint32_t WRITER = 1u << 31;
+    static constexpr uint32_t READERS = 0xFFFFu;
+    static constexpr uint32_t GENERATION_ONE = 1u << 16;
+    static constexpr uint32_t GENERATION = ~(WRITER | READERS);
+
+    void wait(uint32_t seen);
+
+    std::atomic<uint32_t> state{ 0 };
+    std::atomic<uint32_t> writersWaiting{ 0 };
+};
+
+void WriterPreferringLock::wait(uint32_t seen) {
+    WaitOnAddress(&state, &seen, sizeof(seen), INFINITE);
+}
+
+void WriterPreferringLock::lock() {
+    writersWaiting.fetch_add(1, std::memory_order_relaxed);
+    for (;;) {
+        uint32_t seen = state.load(std::memory_order_relaxed);
+        if (!(seen & (WRITER | READERS))) {
+            if (state.compare_exchange_weak(seen, seen | WRITER, std::memory_order_acquire)) {
+                break;
+            }
+            continue;
+        }
+        wait(seen);
+    }
+    writersWaiting.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void WriterPreferringLock::unlock() {
+    const uint32_t seen = state.load(std::memory_order_relaxed);
+    state.store((seen + GENERATION_ONE) & GENERATION, std::memory_order_release);
+    WakeByAddressAll(&state);
+}
+
+void WriterPreferringLock::lockShared() {
+    for (;;) {
+        uint32_t seen = state.load(std::memory_order_relaxed);
+        if (!(seen & WRITER) && writersWaiting.load(std::memory_order_relaxed) == 0) {
+            if (state.compare_exchange_weak(seen, seen + 1, std::memory_order_acquire)) {
+                return;
+            }
+            continue;
+        }
+        wait(seen);
+    }
+}
+
+void WriterPreferringLock::unlockShared() {
+    const uint32_t previous = state.fetch_sub(1, std::memory_order_release);
+    if ((previous & READERS) == 1 && writersWaiting.load(std::memory_order_relaxed) > 0) {
+        WakeByAddressAll(&state);
+    }
+}
+
+// What each operation does with the block after copying it: while holding
+// the block's lock, or on the private copy for seqlock readers.
+enum class Workload {
+    None,
+    Spin,     // busy-wait spinNanoseconds, calibrated against the wall clock
+    Checksum, // hash every transferred byte
+};
+
+struct WorkloadConfig {
+    Workload kind = Workload::Spin;
+    uint64_t spinNanoseconds = 50000;
+    // No per-operation work and no pacing between operations: the threads
+    // hammer the blocks, so bandwidth and blocked time show what the
+    // memory and the locks can sustain.
+    bool maxThroughput = false;
+};
+
+inline const char* workloadName(const WorkloadConfig& workload) {
+    if (workload.maxThroughput) return "max throughput";
+    switch (workload.kind) {
+    case Workload::None: return "none";
+    case Workload::Spin: return "spin";
+    case Workload::Checksum: return "checksum";
+    }
+    return "none";
+}
+
+#define CACHE_LINE_BYTES 64
+
+struct SharedMemoryLayout {
+    // Block stride alignment, rounded up to a power of two and capped at the
+    // page size. From a cache line up, each block's metadata also gets a
+    // line of its own; below that blocks and metadata are packed.
+    size_t blockAlignment = CACHE_LINE_BYTES;
+    // One counter shard per hardware thread instead of a single shared set.
+    bool shardedStats = true;
+};
+
+#define SHARED_SEGMENT_MAGIC 0x4D454853 // "SHEM"
+#define SHARED_SEGMENT_VERSION 2
+#define SHARED_SEGMENT_ATTACH_TIMEOUT_MS 5000
+// Failed seqlock attempts before a reader checks whether the writer died.
+#define SEQLOCK_RECOVERY_RETRIES 1024
+
+// Every segment starts with this header; the block metadata follows at
+// metadataOffset and the blocks at dataOffset. The creator publishes magic
+// last, so a process that attaches sees either nothing or the whole layout.
+struct SegmentHeader {
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t readPolicy;
+    uint32_t reserved;
+    uint64_t blockSize;
+    uint64_t blockCount;
+    uint64_t blockStride;
+    uint64_t metadataStride;
+    uint64_t metadataOffset;
+    uint64_t dataOffset;
+    alignas(CACHE_LINE_BYTES) std::atomic<uint64_t> abandonedLocks;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "Segment counters must be lock-free to live in shared memory");
+
 class SharedMemory {
 public:
-    SharedMemory(size_t memorySize, size_t blockSize);
+    SharedMemory(size_t memorySize, size_t blockSize, ReadPolicy readPolicy = ReadPolicy::Mutex, WorkloadConfig workload = {},
+                 SharedMemoryLayout layout = {});
+    // Creates the named segment, or attaches to it when another process
+    // already did; an empty name gives a private, unnamed segment.
+    SharedMemory(const std::string& segmentName, size_t memorySize, size_t blockSize, ReadPolicy readPolicy = ReadPolicy::Mutex,
+                 WorkloadConfig workload = {}, SharedMemoryLayout layout = {});
     ~SharedMemory();
 
+    bool isOpen() const;
+
     void writeBlock(size_t blockIndex, const void* data, size_t dataSize);
     void readBlock(size_t blockIndex, void* buffer, size_t bufferSize);
 
+    ReadPolicy getReadPolicy() const;
+    const WorkloadConfig& getWorkload() const;
+    const SharedMemoryLayout& getLayout() const;
+    size_t getBlockSize() const;
+    size_t getBlockStride() const;
+    const std::string& getSegmentName() const;
+    uint64_t getAbandonedLocks() const;
     double getBandwidth() const;
+    double getReadBandwidth() const;
     double getActiveTime(size_t blockIndex) const;
     double getBlockedTime(size_t blockIndex) const;
+    uint64_t getReadRetries(size_t blockIndex) const;
+    double getReaderWaitOnWriters(size_t blockIndex) const;
+    double getReaderWaitOnReaders(size_t blockIndex) const;
     bool isBlockAccessed(size_t blockIndex) const;
 
 private:
+    // Counters live in whole cache lines so shards and, when aligned, block
+    // metadata never share one.
+    struct alignas(CACHE_LINE_BYTES) CounterLine {
+        std::atomic<uint64_t> words[CACHE_LINE_BYTES / sizeof(std::atomic<uint64_t>)];
+    };
+    static constexpr size_t WORDS_PER_LINE = CACHE_LINE_BYTES / sizeof(std::atomic<uint64_t>);
+
+    // Per-block lock and occupancy state, kept in the segment so every
+    // attached process sees it. writers counts writers holding or
+    // waiting for the block; readers wait time is blamed on them when any
+    // were there as the wait began, on other readers otherwise. holder
+    // records which of those counts the mutex owner has taken, so they can
+    // be given back if it dies holding the mutex.
+    struct BlockMetadata {
+        std::atomic<uint64_t> sequence{ 0 };
+        std::atomic<uint32_t> accessors{ 0 };
+        std::atomic<uint32_t> writers{ 0 };
+        std::atomic<uint32_t> holder{ 0 };
+        SRWLOCK sharedLock = SRWLOCK_INIT;
+        WriterPreferringLock writerPreferringLock;
+    };
+
+    enum HolderCount : uint32_t { HOLDS_WRITER = 1, HOLDS_ACCESSOR = 2 };
+
+    enum ShardTotal { SHARD_BYTES_WRITTEN, SHARD_BYTES_READ, SHARD_CHECKSUM, SHARD_TOTALS };
+    enum ShardBlockCounter {
+        SHARD_ACTIVE_NS,
+        SHARD_BLOCKED_NS,
+        SHARD_READ_RETRIES,
+        SHARD_READER_WAIT_WRITERS_NS,
+        SHARD_READER_WAIT_READERS_NS,
+        SHARD_BLOCK_COUNTERS,
+    };
+
+    char* blockAddress(size_t blockIndex) const;
+    BlockMetadata& blockState(size_t blockIndex) const;
+    bool holdsMutex(bool exclusive) const;
+    bool lockExclusive(size_t blockIndex);
+    void unlockExclusive(size_t blockIndex);
+    bool lockShared(size_t blockIndex);
+    void unlockShared(size_t blockIndex);
+    bool acquireMutex(size_t blockIndex);
+    void recoverAbandoned(size_t blockIndex);
+    void recoverStalledWriter(size_t blockIndex);
+    bool open(uint64_t mappingBytes);
+    void close();
+    std::atomic<uint64_t>& shardWord(size_t shard, size_t word) const;
+    std::atomic<uint64_t>& shardTotal(ShardTotal total) const;
+    std::atomic<uint64_t>& shardCounter(size_t blockIndex, ShardBlockCounter counter) const;
+    uint64_t sumShards(size_t word) const;
+    static size_t threadShard(size_t shardCount);
+
+    bool readOptimistic(size_t blockIndex, void* buffer, size_t bufferSize);
+    void doWork(const void* data, size_t dataSize);
+
     size_t memorySize;
     size_t blockSize;
     size_t blockCount;
-    HANDLE hFileMapping;
-    void* pSharedMemory;
+    size_t blockStride;
+    ReadPolicy readPolicy;
+    WorkloadConfig workload;
+    SharedMemoryLayout layout;
+    std::string segmentName;
+    HANDLE hFileMapping = NULL;
+    void* pSharedMemory = nullptr;
+    SegmentHeader* header = nullptr;
     std::vector<HANDLE> mutexes;
-    std::vector<std::chrono::high_resolution_clock::time_point> activeStartTimes;
-    std::vector<std::chrono::high_resolution_clock::time_point> blockedStartTimes;
-    std::vector<double> activeTimes;
-    std::vector<double> blockedTimes;
-    std::vector<std::unique_ptr<std::atomic<bool>>> blockAccessed;
-    std::atomic<double> totalBytesTransferred;
+    size_t metadataStride;
+    size_t metadataOffset;
+    size_t dataOffset;
+    size_t shardCount;
+    size_t shardStride;
+    std::unique_ptr<CounterLine[]> shards;
     std::chrono::high_resolution_clock::time_point startTime;
 };
 
-SharedMemory::SharedMemory(size_t memorySize, size_t blockSize)
-    : memorySize(memorySize), blockSize(blockSize), totalBytesTransferred(0) {
-    blockCount = memorySize / blockSize;
-    hFileMapping = CreateFileMapping(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, memorySize, NULL);
-    pSharedMemory = MapViewOfFile(hFileMapping, FILE_MAP_ALL_ACCESS, 0, 0, memorySize);
+uint64_t elapsedNanoseconds(std::chrono::high_resolution_clock::time_point start, std::chrono::high_resolution_clock::time_point end) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
 
-    for (size_t i = 0; i < blockCount; ++i) {
-        HANDLE hMutex = CreateMutex(NULL, FALSE, NULL);
-        mutexes.push_back(hMutex);
-        activeTimes.push_back(0);
-        blockedTimes.push_back(0);
-        blockAccessed.push_back(std::make_unique<std::atomic<bool>>(false));
+SharedMemory::SharedMemory(size_t memorySize, size_t blockSize, ReadPolicy readPolicy, WorkloadConfig workload, SharedMemoryLayout layout)
+    : SharedMemory(std::string(), memorySize, blockSize, readPolicy, workload, layout) {
+}
+
+SharedMemory::SharedMemory(const std::string& segmentName, size_t memorySize, size_t blockSize, ReadPolicy readPolicy,
+                           WorkloadConfig workload, SharedMemoryLayout layout)
+    : memorySize(memorySize), blockSize(blockSize), readPolicy(readPolicy), workload(workload), layout(layout), segmentName(segmentName) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    size_t alignment = 1;
+    while (alignment < layout.blockAlignment && alignment < info.dwPageSize) {
+        alignment *= 2;
+    }
+    this->layout.blockAlignment = alignment;
+    blockStride = (blockSize + alignment - 1) / alignment * alignment;
+    blockCount = blockSize ? memorySize / blockSize : 0;
+
+    // SRW locks and WaitOnAddress only work inside one process, and neither
+    // survives an owner that dies; named mutexes do both.
+    if (!segmentName.empty() && readPolicy != ReadPolicy::Mutex && readPolicy != ReadPolicy::Seqlock) {
+        std::cerr << "The " << readPolicyName(readPolicy) << " policy is process-local; segment " << segmentName << " uses the mutex." << std::endl;
+        this->readPolicy = ReadPolicy::Mutex;
+    }
+
+    metadataStride = alignment >= CACHE_LINE_BYTES ? (sizeof(BlockMetadata) + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES * CACHE_LINE_BYTES
+                                                   : sizeof(BlockMetadata);
+    metadataOffset = (sizeof(SegmentHeader) + CACHE_LINE_BYTES - 1) / CACHE_LINE_BYTES * CACHE_LINE_BYTES;
+    const uint64_t dataAlignment = std::max<uint64_t>(alignment, CACHE_LINE_BYTES);
+    dataOffset = static_cast<size_t>((metadataOffset + blockCount * metadataStride + dataAlignment - 1) / dataAlignment * dataAlignment);
+
+    shardCount = layout.shardedStats ? std::max(1u, std::thread::hardware_concurrency()) : 1;
+    shardStride = (SHARD_TOTALS + blockCount * SHARD_BLOCK_COUNTERS + WORDS_PER_LINE - 1) / WORDS_PER_LINE * WORDS_PER_LINE;
+    shards.reset(new CounterLine[shardCount * shardStride / WORDS_PER_LINE]());
+
+    if (!open(dataOffset + static_cast<uint64_t>(blockCount) * blockStride)) {
+        close();
+        blockCount = 0;
     }
 
     startTime = std::chrono::high_resolution_clock::now();
 }
 
-SharedMemory::~SharedMemory() {
+bool SharedMemory::open(uint64_t mappingBytes) {
+    const std::string base = "Local\\" + segmentName + "Segment";
+    const char* mappingName = segmentName.empty() ? NULL : base.c_str();
+
+    // Whichever process starts first creates the segment; the pagefile-backed
+    // section is zero-filled, which is already a valid idle block state.
+    hFileMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, static_cast<DWORD>(mappingBytes >> 32),
+                                      static_cast<DWORD>(mappingBytes), mappingName);
+    if (!hFileMapping) {
+        std::cerr << "Failed to create shared memory " << (mappingName ? base : "segment") << " (" << GetLastError() << ")." << std::endl;
+        return false;
+    }
+    const bool created = !mappingName || GetLastError() != ERROR_ALREADY_EXISTS;
+
+    pSharedMemory = MapViewOfFile(hFileMapping, FILE_MAP_ALL_ACCESS, 0, 0, static_cast<SIZE_T>(mappingBytes));
+    if (!pSharedMemory) {
+        std::cerr << "Failed to map shared memory " << (mappingName ? base : "segment") << " (" << GetLastError() << ")." << std::endl;
+        return false;
+    }
+    header = static_cast<SegmentHeader*>(pSharedMemory);
+
+    if (created) {
+        for (size_t i = 0; i < blockCount; ++i) {
+            new (&blockState(i)) BlockMetadata();
+        }
+        header->version = SHARED_SEGMENT_VERSION;
+        header->readPolicy = static_cast<uint32_t>(readPolicy);
+        header->blockSize = blockSize;
+        header->blockCount = blockCount;
+        header->blockStride = blockStride;
+        header->metadataStride = metadataStride;
+        header->metadataOffset = metadataOffset;
+        header->dataOffset = dataOffset;
+        header->magic.store(SHARED_SEGMENT_MAGIC, std::memory_order_release);
+    } else {
+        ULONGLONG deadline = GetTickCount64() + SHARED_SEGMENT_ATTACH_TIMEOUT_MS;
+        while (header->magic.load(std::memory_order_acquire) != SHARED_SEGMENT_MAGIC) {
+            if (GetTickCount64() > deadline) {
+                std::cerr << "Timed out waiting for shared memory " << base << " to be initialized." << std::endl;
+                return false;
+            }
+            Sleep(1);
+        }
+        if (header->version != SHARED_SEGMENT_VERSION || header->readPolicy != static_cast<uint32_t>(readPolicy) ||
+            header->blockSize != blockSize || header->blockCount != blockCount || header->blockStride != blockStride ||
+            header->metadataStride != metadataStride || header->metadataOffset != metadataOffset || header->dataOffset != dataOffset) {
+            std::cerr << "Shared memory " << base << " was created with a different layout." << std::endl;
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < blockCount; ++i) {
+        const std::string mutexName = base + "Block" + std::to_string(i);
+        HANDLE hMutex = CreateMutexA(NULL, FALSE, mappingName ? mutexName.c_str() : NULL);
+        if (!hMutex) {
+            std::cerr << "Failed to create the mutex for block " << i << " (" << GetLastError() << ")." << std::endl;
+            return false;
+        }
+        mutexes.push_back(hMutex);
+    }
+    return true;
+}
+
+void SharedMemory::close() {
     for (HANDLE hMutex : mutexes) {
         CloseHandle(hMutex);
     }
-    UnmapViewOfFile(pSharedMemory);
-    CloseHandle(hFileMapping);
+    mutexes.clear();
+    if (pSharedMemory) UnmapViewOfFile(pSharedMemory);
+    if (hFileMapping) CloseHandle(hFileMapping);
+    pSharedMemory = nullptr;
+    header = nullptr;
+    hFileMapping = NULL;
+}
+
+SharedMemory::~SharedMemory() {
+    close();
+}
+
+bool SharedMemory::isOpen() const {
+    return pSharedMemory != nullptr;
+}
+
+char* SharedMemory::blockAddress(size_t blockIndex) const {
+    return static_cast<char*>(pSharedMemory) + dataOffset + blockIndex * blockStride;
+}
+
+SharedMemory::BlockMetadata& SharedMemory::blockState(size_t blockIndex) const {
+    return *reinterpret_cast<BlockMetadata*>(static_cast<char*>(pSharedMemory) + metadataOffset + blockIndex * metadataStride);
+}
+
+// Mutex and seqlock writers serialize on the block's mutex; seqlock
+// readers never take it.
+bool SharedMemory::holdsMutex(bool exclusive) const {
+    return readPolicy == ReadPolicy::Mutex || (exclusive && readPolicy == ReadPolicy::Seqlock);
+}
+
+bool SharedMemory::lockExclusive(size_t blockIndex) {
+    switch (readPolicy) {
+    case ReadPolicy::SharedLock: AcquireSRWLockExclusive(&blockState(blockIndex).sharedLock); return true;
+    case ReadPolicy::WriterPreferring: blockState(blockIndex).writerPreferringLock.lock(); return true;
+    default: return acquireMutex(blockIndex);
+    }
+}
+
+void SharedMemory::unlockExclusive(size_t blockIndex) {
+    switch (readPolicy) {
+    case ReadPolicy::SharedLock: ReleaseSRWLockExclusive(&blockState(blockIndex).sharedLock); break;
+    case ReadPolicy::WriterPreferring: blockState(blockIndex).writerPreferringLock.unlock(); break;
+    default: ReleaseMutex(mutexes[blockIndex]); break;
+    }
+}
+
+bool SharedMemory::lockShared(size_t blockIndex) {
+    switch (readPolicy) {
+    case ReadPolicy::SharedLock: AcquireSRWLockShared(&blockState(blockIndex).sharedLock); return true;
+    case ReadPolicy::WriterPreferring: blockState(blockIndex).writerPreferringLock.lockShared(); return true;
+    default: return acquireMutex(blockIndex);
+    }
+}
+
+void SharedMemory::unlockShared(size_t blockIndex) {
+    switch (readPolicy) {
+    case ReadPolicy::SharedLock: ReleaseSRWLockShared(&blockState(blockIndex).sharedLock); break;
+    case ReadPolicy::WriterPreferring: blockState(blockIndex).writerPreferringLock.unlockShared(); break;
+    default: ReleaseMutex(mutexes[blockIndex]); break;
+    }
+}
+
+bool SharedMemory::acquireMutex(size_t blockIndex) {
+    const DWORD result = WaitForSingleObject(mutexes[blockIndex], INFINITE);
+    if (result == WAIT_ABANDONED) {
+        recoverAbandoned(blockIndex);
+    }
+    if (result == WAIT_OBJECT_0 || result == WAIT_ABANDONED) {
+        return true;
+    }
+    std::cerr << "Failed to lock the mutex for block " << blockIndex << " (" << GetLastError() << ")." << std::endl;
+    return false;
+}
+
+// The previous owner exited while holding the block's mutex and we now own
+// it. Give back the counts it had taken, and close an odd sequence so
+// seqlock readers stop retrying on a writer that died mid-copy. The block
+// may hold a torn write; abandonedLocks records that it happened.
+void SharedMemory::recoverAbandoned(size_t blockIndex) {
+    BlockMetadata& state = blockState(blockIndex);
+    const uint32_t holder = state.holder.exchange(0, std::memory_order_relaxed);
+    if (holder & HOLDS_WRITER) {
+        state.writers.fetch_sub(1, std::memory_order_relaxed);
+    }
+    if (holder & HOLDS_ACCESSOR) {
+        state.accessors.fetch_sub(1, std::memory_order_relaxed);
+    }
+    const uint64_t sequence = state.sequence.load(std::memory_order_relaxed);
+    if (sequence & 1) {
+        state.sequence.store(sequence + 1, std::memory_order_release);
+    }
+    header->abandonedLocks.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Seqlock readers never take the mutex, so without this a writer that
+// died mid-copy would leave them retrying until the next writer came.
+void SharedMemory::recoverStalledWriter(size_t blockIndex) {
+    const DWORD result = WaitForSingleObject(mutexes[blockIndex], 0);
+    if (result == WAIT_ABANDONED) {
+        recoverAbandoned(blockIndex);
+    }
+    if (result == WAIT_ABANDONED || result == WAIT_OBJECT_0) {
+        ReleaseMutex(mutexes[blockIndex]);
+    } else if (result != WAIT_TIMEOUT) {
+        std::cerr << "Failed to check the mutex for block " << blockIndex << " (" << GetLastError() << ")." << std::endl;
+    }
+}
+
+std::atomic<uint64_t>& SharedMemory::shardWord(size_t shard, size_t word) const {
+    word += shard * shardStride;
+    return shards[word / WORDS_PER_LINE].words[word % WORDS_PER_LINE];
+}
+
+// Threads are dealt shards round-robin in the order they first touch any
+// SharedMemory; beyond one thread per hardware thread they double up.
+size_t SharedMemory::threadShard(size_t shardCount) {
+    static std::atomic<size_t> nextThread(0);
+    thread_local const size_t thread = nextThread++;
+    return thread % shardCount;
+}
+
+std::atomic<uint64_t>& SharedMemory::shardTotal(ShardTotal total) const {
+    return shardWord(threadShard(shardCount), total);
+}
+
+std::atomic<uint64_t>& SharedMemory::shardCounter(size_t blockIndex, ShardBlockCounter counter) const {
+    return shardWord(threadShard(shardCount), SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + counter);
+}
+
+// Shards are only summed here, when the UI asks.
+uint64_t SharedMemory::sumShards(size_t word) const {
+    uint64_t sum = 0;
+    for (size_t shard = 0; shard < shardCount; ++shard) {
+        sum += shardWord(shard, word).load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void SharedMemory::doWork(const void* data, size_t dataSize) {
+    if (workload.maxThroughput) return;
+
+    if (workload.kind == Workload::Spin) {
+        const auto until = std::chrono::high_resolution_clock::now() + std::chrono::nanoseconds(workload.spinNanoseconds);
+        while (std::chrono::high_resolution_clock::now() < until) {
+            YieldProcessor();
+        }
+    } else if (workload.kind == Workload::Checksum) {
+        // FNV-1a; the sink keeps the hash from being optimized away.
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        uint64_t hash = 0xCBF29CE484222325ull;
+        for (size_t i = 0; i < dataSize; ++i) {
+            hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+        }
+        shardTotal(SHARD_CHECKSUM).fetch_xor(hash, std::memory_order_relaxed);
+    }
 }
 
 void SharedMemory::writeBlock(size_t blockIndex, const void* data, size_t dataSize) {
     if (blockIndex >= blockCount || dataSize > blockSize) return;
 
+    BlockMetadata& state = blockState(blockIndex);
+    const bool mutexHeld = holdsMutex(true);
+    state.writers.fetch_add(1, std::memory_order_relaxed);
     auto blockedStart = std::chrono::high_resolution_clock::now();
-    WaitForSingleObject(mutexes[blockIndex], INFINITE);
+    if (!lockExclusive(blockIndex)) {
+        state.writers.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
     auto blockedEnd = std::chrono::high_resolution_clock::now();
-    blockedTimes[blockIndex] += std::chrono::duration<double>(blockedEnd - blockedStart).count();
+    shardCounter(blockIndex, SHARD_BLOCKED_NS).fetch_add(elapsedNanoseconds(blockedStart, blockedEnd), std::memory_order_relaxed);
 
-    *blockAccessed[blockIndex] = true;
+    // Each count is taken before holder claims it and disclaimed before it
+    // is given back, so dying in between can only leak a count.
+    if (mutexHeld) state.holder.store(HOLDS_WRITER, std::memory_order_relaxed);
+    state.accessors.fetch_add(1, std::memory_order_relaxed);
+    if (mutexHeld) state.holder.store(HOLDS_WRITER | HOLDS_ACCESSOR, std::memory_order_relaxed);
     auto activeStart = std::chrono::high_resolution_clock::now();
-    memcpy(static_cast<char*>(pSharedMemory) + blockIndex * blockSize, data, dataSize);
-    Sleep(50); // Simulate processing time
+    // An odd sequence tells optimistic readers a copy is in flight; only the
+    // copy itself is inside the window so readers never wait on the workload.
+    std::atomic<uint64_t>& sequence = state.sequence;
+    const uint64_t before = sequence.load(std::memory_order_relaxed);
+    sequence.store(before + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(blockAddress(blockIndex), data, dataSize);
+    sequence.store(before + 2, std::memory_order_release);
+    doWork(data, dataSize);
     auto activeEnd = std::chrono::high_resolution_clock::now();
-    activeTimes[blockIndex] += std::chrono::duration<double>(activeEnd - activeStart).count();
-    *blockAccessed[blockIndex] = false;
+    shardCounter(blockIndex, SHARD_ACTIVE_NS).fetch_add(elapsedNanoseconds(activeStart, activeEnd), std::memory_order_relaxed);
+    if (mutexHeld) state.holder.store(HOLDS_WRITER, std::memory_order_relaxed);
+    state.accessors.fetch_sub(1, std::memory_order_relaxed);
 
-    totalBytesTransferred += dataSize;
-    ReleaseMutex(mutexes[blockIndex]);
+    shardTotal(SHARD_BYTES_WRITTEN).fetch_add(dataSize, std::memory_order_relaxed);
+    if (mutexHeld) state.holder.store(0, std::memory_order_relaxed);
+    unlockExclusive(blockIndex);
+    state.writers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+// One seqlock attempt: succeeds only if no writer was inside the block
+// before or during the copy.
+bool SharedMemory::readOptimistic(size_t blockIndex, void* buffer, size_t bufferSize) {
+    const std::atomic<uint64_t>& sequence = blockState(blockIndex).sequence;
+    const uint64_t before = sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+        return false;
+    }
+    memcpy(buffer, blockAddress(blockIndex), bufferSize);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return sequence.load(std::memory_order_relaxed) == before;
 }
 
 void SharedMemory::readBlock(size_t blockIndex, void* buffer, size_t bufferSize) {
     if (blockIndex >= blockCount || bufferSize > blockSize) return;
 
+    if (readPolicy == ReadPolicy::Seqlock) {
+        // Blocked time is what torn or interrupted attempts cost before the
+        // copy that stuck; the processing happens on the private copy.
+        auto blockedStart = std::chrono::high_resolution_clock::now();
+        auto attemptStart = blockedStart;
+        blockState(blockIndex).accessors.fetch_add(1, std::memory_order_relaxed);
+        for (uint64_t attempt = 1; !readOptimistic(blockIndex, buffer, bufferSize); ++attempt) {
+            shardCounter(blockIndex, SHARD_READ_RETRIES).fetch_add(1, std::memory_order_relaxed);
+            if (attempt % SEQLOCK_RECOVERY_RETRIES == 0) {
+                recoverStalledWriter(blockIndex);
+            }
+            YieldProcessor();
+            attemptStart = std::chrono::high_resolution_clock::now();
+        }
+        // Only a writer can make an attempt fail.
+        const uint64_t blocked = elapsedNanoseconds(blockedStart, attemptStart);
+        shardCounter(blockIndex, SHARD_BLOCKED_NS).fetch_add(blocked, std::memory_order_relaxed);
+        shardCounter(blockIndex, SHARD_READER_WAIT_WRITERS_NS).fetch_add(blocked, std::memory_order_relaxed);
+        doWork(buffer, bufferSize);
+        auto activeEnd = std::chrono::high_resolution_clock::now();
+        shardCounter(blockIndex, SHARD_ACTIVE_NS).fetch_add(elapsedNanoseconds(attemptStart, activeEnd), std::memory_order_relaxed);
+        blockState(blockIndex).accessors.fetch_sub(1, std::memory_order_relaxed);
+        shardTotal(SHARD_BYTES_READ).fetch_add(bufferSize, std::memory_order_relaxed);
+        return;
+    }
+
+    BlockMetadata& state = blockState(blockIndex);
+    const bool mutexHeld = holdsMutex(false);
+    const bool writersPresent = state.writers.load(std::memory_order_relaxed) > 0;
     auto blockedStart = std::chrono::high_resolution_clock::now();
-    WaitForSingleObject(mutexes[blockIndex], INFINITE);
+    if (!lockShared(blockIndex)) return;
     auto blockedEnd = std::chrono::high_resolution_clock::now();
-    blockedTimes[blockIndex] += std::chrono::duration<double>(blockedEnd - blockedStart).count();
+    const uint64_t blocked = elapsedNanoseconds(blockedStart, blockedEnd);
+    shardCounter(blockIndex, SHARD_BLOCKED_NS).fetch_add(blocked, std::memory_order_relaxed);
+    shardCounter(blockIndex, writersPresent ? SHARD_READER_WAIT_WRITERS_NS : SHARD_READER_WAIT_READERS_NS).fetch_add(blocked, std::memory_order_relaxed);
 
-    *blockAccessed[blockIndex] = true;
+    state.accessors.fetch_add(1, std::memory_order_relaxed);
+    if (mutexHeld) state.holder.store(HOLDS_ACCESSOR, std::memory_order_relaxed);
     auto activeStart = std::chrono::high_resolution_clock::now();
-    memcpy(buffer, static_cast<char*>(pSharedMemory) + blockIndex * blockSize, bufferSize);
-    Sleep(50); // Simulate processing time
+    memcpy(buffer, blockAddress(blockIndex), bufferSize);
+    doWork(buffer, bufferSize);
     auto activeEnd = std::chrono::high_resolution_clock::now();
-    activeTimes[blockIndex] += std::chrono::duration<double>(activeEnd - activeStart).count();
-    *blockAccessed[blockIndex] = false;
+    shardCounter(blockIndex, SHARD_ACTIVE_NS).fetch_add(elapsedNanoseconds(activeStart, activeEnd), std::memory_order_relaxed);
+    if (mutexHeld) state.holder.store(0, std::memory_order_relaxed);
+    state.accessors.fetch_sub(1, std::memory_order_relaxed);
+
+    shardTotal(SHARD_BYTES_READ).fetch_add(bufferSize, std::memory_order_relaxed);
+    unlockShared(blockIndex);
+}
+
+ReadPolicy SharedMemory::getReadPolicy() const {
+    return readPolicy;
+}
+
+const WorkloadConfig& SharedMemory::getWorkload() const {
+    return workload;
+}
 
-    ReleaseMutex(mutexes[blockIndex]);
+const SharedMemoryLayout& SharedMemory::getLayout() const {
+    return layout;
+}
+
+size_t SharedMemory::getBlockSize() const {
+    return blockSize;
+}
+
+size_t SharedMemory::getBlockStride() const {
+    return blockStride;
+}
+
+const std::string& SharedMemory::getSegmentName() const {
+    return segmentName;
+}
+
+uint64_t SharedMemory::getAbandonedLocks() const {
+    return header ? header->abandonedLocks.load(std::memory_order_relaxed) : 0;
 }
 
 double SharedMemory::getBandwidth() const {
     auto now = std::chrono::high_resolution_clock::now();
     double elapsedTime = std::chrono::duration<double>(now - startTime).count();
-    return totalBytesTransferred / elapsedTime;
+    return sumShards(SHARD_BYTES_WRITTEN) / elapsedTime;
+}
+
+double SharedMemory::getReadBandwidth() const {
+    auto now = std::chrono::high_resolution_clock::now();
+    double elapsedTime = std::chrono::duration<double>(now - startTime).count();
+    return sumShards(SHARD_BYTES_READ) / elapsedTime;
 }
 
 double SharedMemory::getActiveTime(size_t blockIndex) const {
     if (blockIndex >= blockCount) return 0;
-    return activeTimes[blockIndex];
+    return sumShards(SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + SHARD_ACTIVE_NS) / 1e9;
 }
 
 double SharedMemory::getBlockedTime(size_t blockIndex) const {
     if (blockIndex >= blockCount) return 0;
-    return blockedTimes[blockIndex];
+    return sumShards(SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + SHARD_BLOCKED_NS) / 1e9;
+}
+
+uint64_t SharedMemory::getReadRetries(size_t blockIndex) const {
+    if (blockIndex >= blockCount) return 0;
+    return sumShards(SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + SHARD_READ_RETRIES);
+}
+
+double SharedMemory::getReaderWaitOnWriters(size_t blockIndex) const {
+    if (blockIndex >= blockCount) return 0;
+    return sumShards(SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + SHARD_READER_WAIT_WRITERS_NS) / 1e9;
+}
+
+double SharedMemory::getReaderWaitOnReaders(size_t blockIndex) const {
+    if (blockIndex >= blockCount) return 0;
+    return sumShards(SHARD_TOTALS + blockIndex * SHARD_BLOCK_COUNTERS + SHARD_READER_WAIT_READERS_NS) / 1e9;
 }
 
 bool SharedMemory::isBlockAccessed(size_t blockIndex) const {
     if (blockIndex >= blockCount) return false;
-    return *blockAccessed[blockIndex];
+    return blockState(blockIndex).accessors.load(std::memory_order_relaxed) > 0;
 }
 
 
 
 
 
-void writerThread(SharedMemory& sharedMemory, size_t blockIndex, const std::vector<int>& data, const std::atomic<bool>& running) {
+// Outside max-throughput mode the threads pace themselves between
+// operations so the block table stays readable.
+void writerThread(SharedMemory& sharedMemory, size_t blockIndex, const std::vector<char>& data, const std::atomic<bool>& running) {
+    const bool paced = !sharedMemory.getWorkload().maxThroughput;
     while (running) {
-        for (const int& value : data) {
-            if (!running) return;
-            sharedMemory.writeBlock(blockIndex, &value, sizeof(value));
+        sharedMemory.writeBlock(blockIndex, data.data(), data.size());
+        if (paced) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
 }
 
-void readerThread(SharedMemory& sharedMemory, size_t blockIndex, size_t readCount, const std::atomic<bool>& running) {
-    int buffer;
+void readerThread(SharedMemory& sharedMemory, size_t blockIndex, size_t readSize, const std::atomic<bool>& running) {
+    const bool paced = !sharedMemory.getWorkload().maxThroughput;
+    std::vector<char> buffer(readSize);
     while (running) {
-        for (size_t i = 0; i < readCount; ++i) {
-            if (!running) return;
-            sharedMemory.readBlock(blockIndex, &buffer, sizeof(buffer));
+        sharedMemory.readBlock(blockIndex, buffer.data(), buffer.size());
+        if (paced) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
-}
\ No newline at end of file
+}
+
+struct SharedMemoryScalingPoint {
+    unsigned threads = 0;
+    bool aligned = false;
+    double writeBandwidth = 0.0;
+    double readBandwidth = 0.0;
+    double blockedSeconds = 0.0;
+};
+
+// Runs 8..maxThreads threads (one writer per three readers, spread over the
+// blocks) in max-throughput mode, once with packed blocks and one shared
+// counter set and once with cache-line-aligned blocks and sharded counters,
+// so the cost of false sharing shows up as the thread count grows.
+std::vector<SharedMemoryScalingPoint> sharedMemoryScalingSweep(size_t memorySize, size_t blockSize, ReadPolicy readPolicy, size_t transferSize,
+                                                               unsigned maxThreads = 64, double secondsPerPoint = 1.0) {
+    std::vector<SharedMemoryScalingPoint> points;
+    const size_t numberOfBlocks = blockSize ? memorySize / blockSize : 0;
+    if (numberOfBlocks == 0) {
+        std::cerr << "Shared memory must hold at least one block." << std::endl;
+        return points;
+    }
+    WorkloadConfig workload;
+    workload.maxThroughput = true;
+    const std::vector<char> data(std::min(transferSize, blockSize), 42);
+
+    for (unsigned threads = 8; threads <= maxThreads; threads *= 2) {
+        for (bool aligned : { false, true }) {
+            SharedMemoryLayout layout;
+            layout.blockAlignment = aligned ? CACHE_LINE_BYTES : 1;
+            layout.shardedStats = aligned;
+            SharedMemory sharedMemory(memorySize, blockSize, readPolicy, workload, layout);
+
+            std::atomic<bool> running = true;
+            std::vector<std::thread> workers;
+            for (unsigned i = 0; i < threads; ++i) {
+                if (i % 4 == 0) {
+                    workers.emplace_back(writerThread, std::ref(sharedMemory), i % numberOfBlocks, std::cref(data), std::cref(running));
+                } else {
+                    workers.emplace_back(readerThread, std::ref(sharedMemory), i % numberOfBlocks, data.size(), std::cref(running));
+                }
+            }
+            std::this_thread::sleep_for(std::chrono::duration<double>(secondsPerPoint));
+            running = false;
+            for (std::thread& worker : workers) {
+                worker.join();
+            }
+
+            SharedMemoryScalingPoint point;
+            point.threads = threads;
+            point.aligned = aligned;
+            point.writeBandwidth = sharedMemory.getBandwidth();
+            point.readBandwidth = sharedMemory.getReadBandwidth();
+            for (size_t i = 0; i < numberOfBlocks; ++i) {
+                point.blockedSeconds += sharedMemory.getBlockedTime(i);
+            }
+            points.push_back(point);
+        }
+    }
+    return points;
+}
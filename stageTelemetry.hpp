@@ -0,0 +1,146 @@
+#ifndef STAGE_TELEMETRY_HPP
+#define STAGE_TELEMETRY_HPP
+
+#include <windows.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "pipelineStage.hpp"
+
+// Histogram with power-of-two nanosecond buckets: bucket b counts samples
+// in [2^b, 2^(b+1)) ns. Cheap enough to update for every chunk.
+class LatencyHistogram {
+public:
+    void record(double seconds);
+
+    uint64_t count() const { return samples; }
+    double percentile(double fraction) const;
+    std::string toJson() const;
+
+private:
+    std::array<uint64_t, 64> buckets = {};
+    uint64_t samples = 0;
+    double totalSeconds = 0.0;
+    double minSeconds = 0.0;
+    double maxSeconds = 0.0;
+};
+
+void LatencyHistogram::record(double seconds) {
+    uint64_t nanoseconds = seconds > 0 ? static_cast<uint64_t>(seconds * 1e9) : 0;
+    unsigned bucket = 0;
+    while (nanoseconds > 1 && bucket < buckets.size() - 1) {
+        nanoseconds >>= 1;
+        ++bucket;
+    }
+    ++buckets[bucket];
+
+    minSeconds = samples == 0 ? seconds : std::min(minSeconds, seconds);
+    maxSeconds = samples == 0 ? seconds : std::max(maxSeconds, seconds);
+    totalSeconds += seconds;
+    ++samples;
+}
+
+// Upper bound of the bucket holding the requested rank. The top bucket also
+// takes everything record() clamps into it, so its bound is maxSeconds.
+double LatencyHistogram::percentile(double fraction) const {
+    if (samples == 0) return 0.0;
+    const uint64_t rank = static_cast<uint64_t>(fraction * static_cast<double>(samples - 1)) + 1;
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < buckets.size() - 1; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= rank) {
+            return std::min(static_cast<double>(uint64_t(1) << (bucket + 1)) / 1e9, maxSeconds);
+        }
+    }
+    return maxSeconds;
+}
+
+std::string LatencyHistogram::toJson() const {
+    std::ostringstream json;
+    json << "{\"count\": " << samples
+         << ", \"mean_s\": " << (samples ? totalSeconds / static_cast<double>(samples) : 0.0)
+         << ", \"min_s\": " << minSeconds
+         << ", \"p50_s\": " << percentile(0.50)
+         << ", \"p99_s\": " << percentile(0.99)
+         << ", \"max_s\": " << maxSeconds
+         << ", \"log2_ns_buckets\": [";
+    size_t last = buckets.size();
+    while (last > 0 && buckets[last - 1] == 0) --last;
+    for (size_t bucket = 0; bucket < last; ++bucket) {
+        json << (bucket ? ", " : "") << buckets[bucket];
+    }
+    json << "]}";
+    return json.str();
+}
+
+// Counters one pipeline stage keeps about itself: volume, per-chunk
+// processing latency, time spent blocked on the input and output channels,
+// and how many frames were waiting in the input channel. The stage writes
+// them as JSON to the path given with --telemetry so the launcher can
+// collect them into a single run report.
+class StageTelemetry {
+public:
+    StageTelemetry(const std::string& stageName, const StageArgs& args);
+
+    void addRecords(uint64_t count, uint64_t bytes) { records += count; this->bytes += bytes; }
+    void addChunkLatency(double seconds) { chunkLatency.record(seconds); }
+    void addReadBlocked(double seconds) { readBlockedSeconds += seconds; }
+    void addWriteBlocked(double seconds) { writeBlockedSeconds += seconds; }
+    void sampleQueueDepth(uint64_t frames);
+
+    std::string toJson() const;
+    bool write() const;
+
+private:
+    std::string stageName;
+    std::string outputPath;
+    int64_t startTime;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    LatencyHistogram chunkLatency;
+    double readBlockedSeconds = 0.0;
+    double writeBlockedSeconds = 0.0;
+    uint64_t queueSamples = 0;
+    uint64_t queueDepthTotal = 0;
+    uint64_t queueDepthMax = 0;
+};
+
+StageTelemetry::StageTelemetry(const std::string& stageName, const StageArgs& args)
+    : stageName(stageName), outputPath(args.getString("--telemetry", "")), startTime(PipelineTimestamp()) {}
+
+void StageTelemetry::sampleQueueDepth(uint64_t frames) {
+    ++queueSamples;
+    queueDepthTotal += frames;
+    queueDepthMax = std::max(queueDepthMax, frames);
+}
+
+std::string StageTelemetry::toJson() const {
+    const double elapsed = PipelineSeconds(startTime, PipelineTimestamp());
+    std::ostringstream json;
+    json << "{\"stage\": \"" << stageName << "\""
+         << ", \"elapsed_s\": " << elapsed
+         << ", \"records\": " << records
+         << ", \"bytes\": " << bytes
+         << ", \"records_per_s\": " << (elapsed > 0 ? static_cast<double>(records) / elapsed : 0.0)
+         << ", \"bytes_per_s\": " << (elapsed > 0 ? static_cast<double>(bytes) / elapsed : 0.0)
+         << ", \"read_blocked_s\": " << readBlockedSeconds
+         << ", \"write_blocked_s\": " << writeBlockedSeconds
+         << ", \"queue_depth\": {\"samples\": " << queueSamples
+         << ", \"mean\": " << (queueSamples ? static_cast<double>(queueDepthTotal) / static_cast<double>(queueSamples) : 0.0)
+         << ", \"max\": " << queueDepthMax << "}"
+         << ", \"chunk_latency\": " << chunkLatency.toJson()
+         << "}";
+    return json.str();
+}
+
+bool StageTelemetry::write() const {
+    if (outputPath.empty()) return true;
+    std::ofstream file(outputPath, std::ios::trunc);
+    file << toJson() << std::endl;
+    return static_cast<bool>(file);
+}
+
+#endif // STAGE_TELEMETRY_HPP
@@ -0,0 +1,121 @@
+#include <windows.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+#include "datasetFormat.hpp"
+#include "testCheck.hpp"
+
+#define TEST_RECORDS 10000
+#define TEST_BLOCK_BYTES 4096
+
+// Builds a valid int32 dataset in memory: header, padding, payload and
+// checksum table, laid out the way datasetGenerator writes them.
+std::vector<char> MakeDataset(DatasetHeader& header) {
+    header = MakeDatasetHeader(ElementType::Int32, TEST_RECORDS, TEST_BLOCK_BYTES, true);
+    std::vector<char> file(static_cast<size_t>(header.checksumOffset + DatasetBlockCount(header) * sizeof(uint64_t)), 0);
+
+    const size_t payloadBytes = static_cast<size_t>(DatasetPayloadBytes(header));
+    int32_t* payload = reinterpret_cast<int32_t*>(file.data() + header.payloadOffset);
+    for (size_t i = 0; i < TEST_RECORDS; ++i) {
+        payload[i] = static_cast<int32_t>(i * 2654435761u);
+    }
+    uint64_t* checksums = reinterpret_cast<uint64_t*>(file.data() + header.checksumOffset);
+    for (uint64_t block = 0; block < DatasetBlockCount(header); ++block) {
+        const size_t offset = static_cast<size_t>(block * header.blockBytes);
+        checksums[block] = DatasetChecksum(file.data() + header.payloadOffset + offset, std::min<size_t>(TEST_BLOCK_BYTES, payloadBytes - offset));
+    }
+    std::memcpy(file.data(), &header, sizeof(header));
+    return file;
+}
+
+// Empty when no temporary file could be created.
+std::string TempPath() {
+    char directory[MAX_PATH];
+    char path[MAX_PATH];
+    if (GetTempPathA(MAX_PATH, directory) == 0 || GetTempFileNameA(directory, "dst", 0, path) == 0) {
+        std::cerr << "Failed to create a temporary file (" << GetLastError() << ")." << std::endl;
+        return std::string();
+    }
+    return path;
+}
+
+// Writes the file with an edited header (and optionally edited contents),
+// then runs the header check and, if it passes, the checksum pass.
+bool CheckDataset(const std::function<void(DatasetHeader&, std::vector<char>&)>& edit, bool verifyChecksums = false) {
+    DatasetHeader header;
+    std::vector<char> file = MakeDataset(header);
+    edit(header, file);
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    const std::string path = TempPath();
+    CHECK(!path.empty());
+    if (path.empty()) return false;
+
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL);
+    const bool written = hFile != INVALID_HANDLE_VALUE && WriteExact(hFile, file.data(), file.size());
+    if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
+    CHECK(written);
+
+    bool valid = false;
+    hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        DatasetHeader read;
+        valid = ReadDatasetHeader(hFile, path, read) && (!verifyChecksums || VerifyDatasetChecksums(hFile, path, read));
+        CloseHandle(hFile);
+    }
+    DeleteFileA(path.c_str());
+    return valid;
+}
+
+void TestHeaderValidation() {
+    auto unchanged = [](DatasetHeader&, std::vector<char>&) {};
+    CHECK(CheckDataset(unchanged));
+    CHECK(CheckDataset(unchanged, true));
+
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.magic = 0; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.version = DATASET_VERSION + 1; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.headerBytes = 32; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.elementBytes = 8; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.elementType = 99; header.elementBytes = 0; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.payloadOffset = 4096; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.payloadOffset = ~0ull - DATASET_PAYLOAD_ALIGNMENT + 1; }));
+}
+
+void TestSizesCannotOverflow() {
+    // count * elementBytes wraps to 4 bytes here.
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.count = UINT64_MAX / 4 + 2; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.count = TEST_RECORDS * 4; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.blockBytes = 0; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.blockBytes = MAX_DATASET_BLOCK_BYTES + 1; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.checksumOffset = header.payloadOffset; }));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.checksumOffset = UINT64_MAX - 4; }));
+    CHECK(!CheckDataset([](DatasetHeader&, std::vector<char>& file) { file.resize(file.size() - 1); }));
+    CHECK(CheckDataset([](DatasetHeader& header, std::vector<char>&) { header.flags = DATASET_FLAG_NONE; header.blockBytes = 0; }));
+}
+
+void TestChecksumsCatchCorruption() {
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>& file) { file[header.payloadOffset + 5000] ^= 1; }, true));
+    CHECK(!CheckDataset([](DatasetHeader& header, std::vector<char>& file) { file[header.checksumOffset] ^= 1; }, true));
+}
+
+void TestElementTypeNames() {
+    for (ElementType type : { ElementType::Int32, ElementType::Int64, ElementType::Float32, ElementType::Float64,
+                              ElementType::Record16, ElementType::Record64, ElementType::Record128 }) {
+        ElementType parsed;
+        CHECK(ParseElementType(ElementTypeName(type), parsed) && parsed == type);
+    }
+    ElementType parsed;
+    CHECK(!ParseElementType("int33", parsed));
+    CHECK(!ParseElementType("", parsed));
+}
+
+int main() {
+    TestHeaderValidation();
+    TestSizesCannotOverflow();
+    TestChecksumsCatchCorruption();
+    TestElementTypeNames();
+    return TestResult();
+}
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "incrementalSort.hpp"
+#include "keyedRecord.hpp"
+#include "testCheck.hpp"
+
+// Keys collide often so that stability is actually exercised; the payload
+// carries the record's position in the input.
+std::vector<Record16> MakeRecords(std::mt19937& rng, size_t count, uint64_t firstPosition, int64_t keyRange) {
+    std::vector<Record16> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        records[i].key = static_cast<int64_t>(rng() % keyRange) - keyRange / 2;
+        const uint64_t position = firstPosition + i;
+        std::memcpy(records[i].payload, &position, sizeof(position));
+    }
+    return records;
+}
+
+uint64_t PositionOf(const Record16& record) {
+    uint64_t position;
+    std::memcpy(&position, record.payload, sizeof(position));
+    return position;
+}
+
+bool SameRecords(const std::vector<Record16>& a, const std::vector<Record16>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const Record16& x, const Record16& y) {
+        return x.key == y.key && PositionOf(x) == PositionOf(y);
+    });
+}
+
+std::vector<Record16> Merge(const std::vector<std::vector<Record16>>& sources) {
+    LoserTree<Record16> tree(sources.size());
+    std::vector<size_t> positions(sources.size(), 0);
+    for (size_t i = 0; i < sources.size(); ++i) {
+        tree.setHead(i, sources[i].empty() ? nullptr : sources[i].data());
+    }
+    tree.build();
+
+    std::vector<Record16> merged;
+    while (!tree.empty()) {
+        merged.push_back(tree.top());
+        const size_t source = tree.winner();
+        tree.replaceWinner(++positions[source] < sources[source].size() ? &sources[source][positions[source]] : nullptr);
+    }
+    return merged;
+}
+
+// Sources are consecutive slices of the input, so a stable merge of the
+// sorted slices must equal a stable sort of the whole input.
+void TestLoserTreeMerge() {
+    std::mt19937 rng(1);
+    for (int trial = 0; trial < 500; ++trial) {
+        const size_t sourceCount = 1 + rng() % 13;
+        std::vector<std::vector<Record16>> sources;
+        std::vector<Record16> expected;
+        for (size_t i = 0; i < sourceCount; ++i) {
+            std::vector<Record16> source = MakeRecords(rng, rng() % 40, expected.size(), 5);
+            expected.insert(expected.end(), source.begin(), source.end());
+            std::stable_sort(source.begin(), source.end());
+            sources.push_back(std::move(source));
+        }
+        std::stable_sort(expected.begin(), expected.end());
+        CHECK(SameRecords(Merge(sources), expected));
+    }
+
+    CHECK(Merge({ {}, {}, {} }).empty());
+}
+
+void TestIncrementalSorterIsStable() {
+    std::mt19937 rng(2);
+    std::vector<Record16> input = MakeRecords(rng, 10000, 0, 17);
+
+    IncrementalSorter<Record16> sorter(3);
+    for (size_t offset = 0; offset < input.size(); offset += 777) {
+        sorter.add(input.data() + offset, std::min<size_t>(777, input.size() - offset));
+    }
+    std::vector<Record16> output;
+    const bool finished = sorter.finish(1000, [&output](const Record16* records, size_t count) {
+        output.insert(output.end(), records, records + count);
+        return true;
+    });
+
+    std::stable_sort(input.begin(), input.end());
+    CHECK(finished);
+    CHECK(SameRecords(output, input));
+}
+
+int main() {
+    TestLoserTreeMerge();
+    TestIncrementalSorterIsStable();
+    return TestResult();
+}
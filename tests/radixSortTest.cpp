@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "keyedRecord.hpp"
+#include "radixSort.hpp"
+#include "testCheck.hpp"
+
+// Every value must map to a key that sorts the same way the value does.
+template <typename T>
+bool KeysKeepOrder(std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    for (size_t i = 1; i < values.size(); ++i) {
+        if (!(RadixKeyOf(values[i - 1]) < RadixKeyOf(values[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void TestKeyExtraction() {
+    CHECK(KeysKeepOrder<int32_t>({ std::numeric_limits<int32_t>::min(), -70000, -1, 0, 1, 255, 256, std::numeric_limits<int32_t>::max() }));
+    CHECK(KeysKeepOrder<int64_t>({ std::numeric_limits<int64_t>::min(), -(int64_t(1) << 40), -1, 0, 1, int64_t(1) << 40, std::numeric_limits<int64_t>::max() }));
+    CHECK(KeysKeepOrder<uint32_t>({ 0, 1, 0x7FFFFFFFu, 0x80000000u, 0xFFFFFFFFu }));
+    CHECK(KeysKeepOrder<uint64_t>({ 0, 1, uint64_t(1) << 63, ~uint64_t(0) }));
+    CHECK(KeysKeepOrder<float>({ -std::numeric_limits<float>::infinity(), -1e30f, -1.5f, -std::numeric_limits<float>::denorm_min(), 0.0f,
+                                 std::numeric_limits<float>::denorm_min(), 1.0f, 1e30f, std::numeric_limits<float>::infinity() }));
+    CHECK(KeysKeepOrder<double>({ -std::numeric_limits<double>::infinity(), -1e300, -2.0, -std::numeric_limits<double>::denorm_min(), 0.0,
+                                  std::numeric_limits<double>::denorm_min(), 0.5, 1e300, std::numeric_limits<double>::infinity() }));
+    CHECK(RadixKeyOf(-0.0f) < RadixKeyOf(0.0f));
+
+    Record64 record = {};
+    record.key = -5;
+    CHECK(RadixKeyOf(record) == RadixKeyOf(int64_t(-5)));
+}
+
+template <typename T>
+void CheckScalarSort(const std::vector<T>& values) {
+    std::vector<T> expected = values;
+    std::sort(expected.begin(), expected.end());
+    for (unsigned threadCount : { 1u, 4u }) {
+        std::vector<T> sorted = values;
+        SortKeys(sorted.data(), sorted.size(), threadCount);
+        CHECK(sorted == expected);
+    }
+}
+
+// The largest size is the smallest that still splits across two workers,
+// so the test stays quick in unoptimized ctest builds.
+void TestScalarSort() {
+    std::mt19937_64 rng(3);
+    for (size_t count : { size_t(0), size_t(1), size_t(1000), size_t(RADIX_MIN_PARALLEL_RECORDS), size_t(RADIX_MIN_RECORDS_PER_THREAD * 2 + 17) }) {
+        std::vector<int32_t> int32s(count);
+        std::vector<int64_t> int64s(count);
+        std::vector<float> floats(count);
+        std::vector<double> doubles(count);
+        for (size_t i = 0; i < count; ++i) {
+            int32s[i] = static_cast<int32_t>(rng());
+            int64s[i] = static_cast<int64_t>(rng());
+            floats[i] = static_cast<float>(static_cast<int32_t>(rng())) / 1024.0f;
+            doubles[i] = static_cast<double>(static_cast<int64_t>(rng())) / 3.0;
+        }
+        CheckScalarSort(int32s);
+        CheckScalarSort(int64s);
+        CheckScalarSort(floats);
+        CheckScalarSort(doubles);
+    }
+}
+
+// Wide records sort by extracted key; records with equal keys must keep
+// their input order, which the payload records.
+template <typename Record>
+void CheckRecordSortIsStable(size_t count, unsigned threadCount) {
+    std::mt19937_64 rng(4);
+    std::vector<Record> records(count);
+    for (size_t i = 0; i < count; ++i) {
+        records[i] = {};
+        records[i].key = static_cast<int64_t>(rng() % 64) - 32;
+        const uint64_t position = i;
+        std::memcpy(records[i].payload, &position, sizeof(position));
+    }
+    std::vector<Record> expected = records;
+    std::stable_sort(expected.begin(), expected.end());
+
+    SortKeys(records.data(), records.size(), threadCount);
+    CHECK(std::equal(records.begin(), records.end(), expected.begin(), [](const Record& a, const Record& b) {
+        return std::memcmp(&a, &b, sizeof(Record)) == 0;
+    }));
+}
+
+void TestRecordSortIsStable() {
+    for (unsigned threadCount : { 1u, 4u }) {
+        CheckRecordSortIsStable<Record16>(1000, threadCount);
+        CheckRecordSortIsStable<Record16>(RADIX_MIN_RECORDS_PER_THREAD * 2 + 5, threadCount);
+        CheckRecordSortIsStable<Record64>(RADIX_MIN_PARALLEL_RECORDS + 3, threadCount);
+        CheckRecordSortIsStable<Record128>(RADIX_MIN_PARALLEL_RECORDS, threadCount);
+    }
+}
+
+int main() {
+    TestKeyExtraction();
+    TestScalarSort();
+    TestRecordSortIsStable();
+    return TestResult();
+}
@@ -0,0 +1,25 @@
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <iostream>
+
+// The test executables report every failed check and keep going, so one run
+// shows all of them; main() returns TestResult() for ctest.
+int testFailures = 0;
+
+#define CHECK(condition)                                                                                  \
+    do {                                                                                                  \
+        if (!(condition)) {                                                                               \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed." << std::endl; \
+            ++testFailures;                                                                               \
+        }                                                                                                 \
+    } while (0)
+
+int TestResult() {
+    if (testFailures) {
+        std::cerr << testFailures << " check(s) failed." << std::endl;
+    }
+    return testFailures ? 1 : 0;
+}
+
+#endif // TEST_CHECK_HPP